@@ -0,0 +1,1246 @@
+/* strstrBench.c - throughput sweep of the strstr implementations in
+ * strstrFunctions.c.
+ *
+ * This file is public domain per CC0 1.0, see
+ * https://creativecommons.org/publicdomain/mark/1.0/
+ *
+ * Each implementation listed in submitters[] is timed while searching
+ * haystacks whose sizes double from 64 bytes up to (by default) 64 MiB, so
+ * the sweep crosses the L1, L2, L3 and DRAM boundaries of the machine it
+ * runs on.  The needle is planted at the very end of the haystack and
+ * cannot occur anywhere else, so every call scans the whole haystack and
+ * throughput is simply haystack bytes per second.  Where GB/s falls off as
+ * the haystack grows an implementation has become memory-bound; where it
+ * stays flat it is still compute-bound.
+ *
+ * Implementations 21 and up are the kernels that accompany strstr.c.
+ * Those for another instruction set than the one compiled for are
+ * skipped, so the numbers stay the same on every machine.
+ * Those that find the last occurrence are timed with -R, which plants the
+ * needle at the start of the haystack instead, against strstr.c called in
+ * a loop.  Those that count occurrences or only test for one are timed
+ * with -C, against the same loop and a plain strstr.c call.
+ *
+ * With -T every measurement is repeated on that many threads at once,
+ * each pinned (on Linux) to its own one of the CPUs the process may run on
+ * and searching the same haystack, or with -P a private copy of it.  The
+ * aggregate throughput and the scaling efficiency, aggregate / (threads *
+ * single-thread throughput), show which implementations saturate shared
+ * memory bandwidth.  The threads run with warm caches, so -T cannot be
+ * combined with -c.
+ *
+ * With -j the run is also recorded as JSON Lines: a "run" object saying
+ * where and how it ran (CPU model, compiler and flags, operating system,
+ * corpus, settings), then a "result" object per measurement with every
+ * sample's GB/s and, where the clock rate is known, cycles per byte.
+ * strstrCompare.c compares two such files for regressions.  On x86 the
+ * clock is the time stamp counter, which ticks at a fixed rate that may
+ * differ from the core's; elsewhere give the rate with -G.  Compile with
+ * -DSTRSTR_CFLAGS="\"$CFLAGS\"" to record the flags.
+ *
+ * With -v nothing is timed.  Instead every implementation is checked
+ * for strstr's exact results on a table of golden cases (empty strings,
+ * needle equal to or longer than the haystack, bytes with the high bit
+ * set, overlapping prefixes) and on a fixed set of generated ones, some
+ * up to 12K long with needles planted across strstrSimd.c's window seams.
+ * Each case is run with the haystack surrounded by copies of the needle
+ * that only a search reading outside it can find, against inaccessible
+ * pages, and in malloc'd blocks of exactly its size.  strstrPattern.c's
+ * compiler and matcher are checked too, on malformed patterns, the
+ * literals they require and the spans they match.  The exit status is 1
+ * if any check fails.  Built with -fsanitize=address, -v also reports any
+ * read past a haystack's or needle's NUL:
+ *
+ *   cc -O1 -g -fsanitize=address -pthread -o strstrBench-asan ...
+ *   ./strstrBench-asan -v
+ *
+ * Build:  cc -O2 -pthread -o strstrBench strstrBench.c strstrFunctions.c \
+ *             ../strstrStream.c ../strstrPrepared.c ../strstrReverse.c \
+ *             ../strstrSimd.c ../strstrIndex.c ../strstrPattern.c
+ *
+ * Usage:  strstrBench [-f csv|gnuplot] [-s minsize] [-S maxsize]
+ *                     [-l needlelens] [-i impls] [-t seconds]
+ *                     [-c] [-E evictsize] [-p distance] [-R | -C]
+ *                     [-T threads [-P]] [-r samples]
+ *                     [-j file [-L label] [-G ghz]]
+ *         strstrBench -v [-i impls]
+ *
+ *   -f  output format: csv (default) or gnuplot
+ *   -s  smallest haystack in bytes, K, M or G suffix allowed (default 64)
+ *   -S  largest haystack (default 64M; up to 4G if memory allows)
+ *   -l  comma separated needle lengths (default 1,2,4,8,16,32,64,128,256)
+ *   -i  comma separated implementation numbers (default all)
+ *   -t  minimum timing interval per measurement in seconds (default 0.05)
+ *   -c  cold cache: evict the caches before every timed call
+ *   -E  bytes written to evict the caches with -c (default 64M; make it
+ *       several times the last level cache)
+ *   -p  strstr_stream prefetch distance in bytes (default 1024)
+ *   -R  time the last-occurrence searches
+ *   -C  time the counting and existence tests
+ *   -T  also time each implementation on this many concurrent threads
+ *       (not with -c)
+ *   -P  give each thread a private copy of the haystack
+ *   -r  take this many samples of each measurement and report the
+ *       median (default 1; use 5 or more for strstrCompare)
+ *   -j  also write the run and its samples as JSON Lines to file
+ *   -L  label for the run in the JSON, such as the commit
+ *   -G  clock rate in GHz for cycles per byte (default: measured on x86)
+ *   -v  check every implementation's results instead of timing them
+ *
+ * The gnuplot format writes one data block per implementation, separated
+ * by two blank lines so each can be selected with "index"; column 1 is the
+ * haystack size and columns 2.. are GB/s for each needle length (aggregate
+ * GB/s with -T), e.g.
+ *
+ *   set datafile missing '?'
+ *   set logscale x 2
+ *   plot for [i=0:20] 'bench.dat' index i using 1:2 with lines
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE         /* for pthread_setaffinity_np, sched_getaffinity */
+#include <sched.h>
+#endif
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/utsname.h>
+#if defined(__APPLE__) || defined(__FreeBSD__)
+#include <sys/types.h>
+#include <sys/sysctl.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>      /* for __rdtsc */
+#endif
+#include "../strstr.h"
+
+#ifndef STRSTR_CFLAGS
+#define STRSTR_CFLAGS	"unknown"
+#endif
+
+typedef char *(*strstr_fn)(const char *, const char *);
+
+extern char *submitters[];
+
+extern char *strstr1(const char *, const char *);
+extern char *strstr2(const char *, const char *);
+extern char *strstr3(const char *, const char *);
+extern char *strstr4(const char *, const char *);
+extern char *strstr5(const char *, const char *);
+extern char *strstr6(const char *, const char *);
+extern char *strstr7(const char *, const char *);
+extern char *strstr8(const char *, const char *);
+extern char *strstr10(const char *, const char *);
+extern char *strstr11(const char *, const char *);
+extern char *strstr12(const char *, const char *);
+extern char *strstr13(const char *, const char *);
+extern char *strstr14(const char *, const char *);
+extern char *strstr15(const char *, const char *);
+extern char *strstr16(const char *, const char *);
+extern char *strstr18(const char *, const char *);
+extern char *strstr19(const char *, const char *);
+extern char *strstr20(const char *, const char *);
+
+static size_t prefetch_distance = STRSTR_PREFETCH_DISTANCE;   /* -p */
+
+static char *stream_t0(const char *s1, const char *s2)
+{
+	return strstr_stream_ex(s1, s2, prefetch_distance, 0);
+}
+
+static char *stream_nta(const char *s1, const char *s2)
+{
+	return strstr_stream_ex(s1, s2, prefetch_distance, 1);
+}
+
+/* The needle is prepared by prepare, before each measurement, so just the
+ * search is timed.
+ */
+static union {
+	strstr_needle n;
+	char mem[sizeof(strstr_needle) + 256];
+} prepared_needle;
+
+static void prepare(const char *s2)
+{
+	strstr_prepare(&prepared_needle, sizeof prepared_needle, s2);
+}
+
+static char *prepared(const char *s1, const char *s2)
+{
+	(void)s2;
+	return strstr_prepared(s1, &prepared_needle.n);
+}
+
+/* The last occurrence the way callers find it without strrstr. */
+static char *rloop(const char *s1, const char *s2)
+{
+	char *p, *last = NULL;
+
+	for (; (p = strstr1(s1, s2)) != NULL; s1 = p + 1) {
+		last = p;
+		if (!*p) break;     // a zero length s2, found at the NUL
+	}
+	return last;
+}
+
+static char *rscalar(const char *s1, const char *s2)
+{
+	return memrmem_scalar(s1, strlen(s1), s2, strlen(s2));
+}
+
+static char *rhorspool(const char *s1, const char *s2)
+{
+	return memrmem_horspool(s1, strlen(s1), s2, strlen(s2));
+}
+
+#ifdef __SSE2__
+static char *rsse2(const char *s1, const char *s2)
+{
+	return memrmem_sse2(s1, strlen(s1), s2, strlen(s2));
+}
+#define SSE2(fn)	fn
+#else
+#define SSE2(fn)	NULL
+#endif
+
+#ifdef __aarch64__
+#define NEON(fn)	fn
+#else
+#define NEON(fn)	NULL
+#endif
+
+#ifdef __ARM_FEATURE_SVE
+#define SVE(fn)		fn
+#else
+#define SVE(fn)		NULL
+#endif
+
+/* Counting and existence tests return s1 + their result, so that they too
+ * can be checked against an expected pointer.
+ */
+static char *cloop(const char *s1, const char *s2)
+{
+	const char *h = s1;
+	size_t k = 0;
+
+	for (; (s1 = strstr1(s1, s2)) != NULL; s1++) {
+		k++;
+		if (!*s1) break;    // a zero length s2, found at the NUL
+	}
+	return (char *)h + k;
+}
+
+static char *ccount(const char *s1, const char *s2)
+{
+	return (char *)s1 + strstr_count(s1, s2);
+}
+
+static char *cstrstr(const char *s1, const char *s2)
+{
+	return (char *)s1 + (strstr1(s1, s2) != NULL);
+}
+
+static char *ccontains(const char *s1, const char *s2)
+{
+	return (char *)s1 + strcontains(s1, s2);
+}
+
+/* Indexing costs far more than a search, so this is only verified. */
+static char *indexed(const char *s1, const char *s2)
+{
+	size_t n = strlen(s1);
+	void *mem = malloc(strstr_index_size(n));
+	void *scratch = malloc(strstr_index_scratch_size(n));
+	strstr_index *ix;
+	char *p = NULL;
+
+	if (mem && scratch
+			&& (ix = strstr_index_build(mem, strstr_index_size(n), s1, scratch))
+			&& (p = strstr_indexed(ix, s2)) != NULL)
+		p = (char *)s1 + (p - ((char *)ix + ix->text));
+	free(scratch);
+	free(mem);
+	return p;
+}
+
+enum { FIND, LAST, COUNT, EXISTS, INDEX };
+
+/* Entries with a NULL name take theirs from submitters[] at the same index.
+ * strstr9 and strstr17 were replaced with the compiler's strstr, as noted
+ * in strstrFunctions.c.
+ */
+static struct impl {
+	const char *name;
+	strstr_fn fn;
+	int mode;           /* FIND, LAST, COUNT, EXISTS or INDEX */
+	void (*setup)(const char *s2);  /* if not NULL, called with each needle */
+} impls[] = {
+	{ NULL, (strstr_fn)strstr },    /* 0  */
+	{ NULL, strstr1 },              /* 1  */
+	{ NULL, strstr2 },              /* 2  */
+	{ NULL, strstr3 },              /* 3  */
+	{ NULL, strstr4 },              /* 4  */
+	{ NULL, strstr5 },              /* 5  */
+	{ NULL, strstr6 },              /* 6  */
+	{ NULL, strstr7 },              /* 7  */
+	{ NULL, strstr8 },              /* 8  */
+	{ NULL, (strstr_fn)strstr },    /* 9  */
+	{ NULL, strstr10 },             /* 10 */
+	{ NULL, strstr11 },             /* 11 */
+	{ NULL, strstr12 },             /* 12 */
+	{ NULL, strstr13 },             /* 13 */
+	{ NULL, strstr14 },             /* 14 */
+	{ NULL, strstr15 },             /* 15 */
+	{ NULL, strstr16 },             /* 16 */
+	{ NULL, (strstr_fn)strstr },    /* 17 */
+	{ NULL, strstr18 },             /* 18 */
+	{ NULL, strstr19 },             /* 19 */
+	{ NULL, strstr20 },             /* 20 */
+	{ "strstr_stream prefetch", stream_t0 },        /* 21 */
+	{ "strstr_stream prefetch NTA", stream_nta },   /* 22 */
+	{ "strstr_prepared (Horspool)", prepared, FIND, prepare },  /* 23 */
+	{ "strstr.c loop (last occurrence)", rloop, LAST },    /* 24 */
+	{ "strrstr", strrstr, LAST },                          /* 25 */
+	{ "memrmem_scalar", rscalar, LAST },                   /* 26 */
+	{ "memrmem_horspool", rhorspool, LAST },               /* 27 */
+	{ "memrmem_sse2", SSE2(rsse2), LAST },                 /* 28 */
+	{ "strstr_simd", strstr_simd },                 /* 29 */
+	{ "strstr_sse2", SSE2(strstr_sse2) },           /* 30 */
+	{ "strstr_neon", NEON(strstr_neon) },           /* 31 */
+	{ "strstr_sve", SVE(strstr_sve) },              /* 32 */
+	{ "strstr.c loop (count)", cloop, COUNT },      /* 33 */
+	{ "strstr_count", ccount, COUNT },              /* 34 */
+	{ "strstr.c != NULL", cstrstr, EXISTS },        /* 35 */
+	{ "strcontains", ccontains, EXISTS },           /* 36 */
+	{ "strstr_short", strstr_short },               /* 37 */
+	{ "strstr_indexed", indexed, INDEX },           /* 38 */
+};
+
+#define NIMPLS	(sizeof impls / sizeof impls[0])
+#define MAXLENS	32
+#define MAXSAMPLES	100
+
+static char *volatile sink;
+static char *evict;         /* cache eviction buffer for -c */
+static size_t evictsize = (size_t)64 << 20;
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Parse a size such as "4096", "32K", "8M" or "4G". */
+static size_t parse_size(const char *s)
+{
+	char *end;
+	size_t n = strtoull(s, &end, 10);
+
+	switch (*end) {
+	case 'k': case 'K': n <<= 10; break;
+	case 'm': case 'M': n <<= 20; break;
+	case 'g': case 'G': n <<= 30; break;
+	}
+	return n;
+}
+
+/* Parse a comma separated list of numbers into v; return the count. */
+static int parse_list(const char *s, size_t *v, int max)
+{
+	int n = 0;
+	char *end;
+
+	while (*s && n < max) {
+		v[n++] = strtoull(s, &end, 10);
+		if (*end != ',') break;
+		s = end + 1;
+	}
+	return n;
+}
+
+/* Fill h[0..n) with pseudo-random lowercase words.  The generator is fixed
+ * so every run and every machine searches identical text.
+ */
+static void fill_haystack(char *h, size_t n)
+{
+	unsigned long x = 2463534242UL;
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		x ^= x << 13; x &= 0xffffffffUL;
+		x ^= x >> 17;
+		x ^= x << 5;  x &= 0xffffffffUL;
+		h[i] = (x % 27) ? 'a' + x % 26 : ' ';
+	}
+}
+
+/* Push the haystack out of every cache level by writing a buffer several
+ * times the size of the last level cache.
+ */
+static void evict_caches(void)
+{
+	size_t i;
+
+	for (i = 0; i < evictsize; i += 64) evict[i]++;
+}
+
+/* One thread of a multi-threaded measurement. */
+struct worker {
+	pthread_t tid;
+	int cpu;
+	strstr_fn fn;
+	const char *h;          /* shared haystack, or the one to copy */
+	size_t n;               /* haystack length */
+	size_t want;            /* offset of the expected result */
+	const char *nd;
+	int private;
+	unsigned long reps;
+	int bad;
+	int pin_error;          /* pthread_setaffinity_np's, or 0 */
+	double end;
+};
+
+static pthread_mutex_t gate_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gate_cond = PTHREAD_COND_INITIALIZER;
+static int gate_ready, gate_open;
+
+static void *work(void *arg)
+{
+	struct worker *w = (struct worker *)arg;
+	const char *h = w->h;
+	char *copy = NULL, *volatile r;
+	unsigned long i;
+
+#ifdef __linux__
+	cpu_set_t cpus;
+
+	if (w->cpu >= 0) {
+		CPU_ZERO(&cpus);
+		CPU_SET(w->cpu, &cpus);
+		w->pin_error = pthread_setaffinity_np(pthread_self(), sizeof cpus,
+		                                      &cpus);
+	}
+#endif
+	// copy after pinning, so the copy is local to the thread's CPU
+	if (w->private && (copy = malloc(w->n + 1)) != NULL) {
+		memcpy(copy, w->h, w->n + 1);
+		h = copy;
+	}
+	w->bad = w->fn(h, w->nd) != h + w->want;
+
+	pthread_mutex_lock(&gate_lock);
+	gate_ready++;
+	pthread_cond_broadcast(&gate_cond);
+	while (!gate_open) pthread_cond_wait(&gate_cond, &gate_lock);
+	pthread_mutex_unlock(&gate_lock);
+
+	for (i = 0; i < w->reps; i++) r = w->fn(h, w->nd);
+	(void)r;
+	w->end = now();
+	free(copy);
+	return NULL;
+}
+
+/* Fill cpus with the numbers of the CPUs the process may run on, which
+ * need not be 0 to n - 1 under taskset or in a container, and return how
+ * many there are, or 0 if they are unknown and threads are not pinned.
+ */
+static int allowed_cpus(int *cpus, int max)
+{
+	int n = 0;
+#ifdef __linux__
+	cpu_set_t set;
+	int i;
+
+	if (sched_getaffinity(0, sizeof set, &set)) {
+		perror("sched_getaffinity: threads are not pinned");
+		return 0;
+	}
+	for (i = 0; i < CPU_SETSIZE && n < max; i++)
+		if (CPU_ISSET(i, &set)) cpus[n++] = i;
+#else
+	(void)cpus;
+	(void)max;
+#endif
+	return n;
+}
+
+/* Return the aggregate throughput in GB/s of nthreads threads each calling
+ * fn reps times at once, or 0 if any of them gets a result other than want.
+ */
+static double measure_threads(strstr_fn fn, const char *h, size_t n,
+                              const char *nd, const char *want,
+                              unsigned long reps, int nthreads, int private)
+{
+	static struct worker *w;
+	static int *cpus, ncpus, warned;
+	double t0, end = 0;
+	int i, bad = 0;
+
+	if (!w) {
+		if (!(w = calloc(nthreads, sizeof *w))
+				|| !(cpus = calloc(nthreads, sizeof *cpus)))
+			return 0;
+		ncpus = allowed_cpus(cpus, nthreads);
+		if (ncpus && ncpus < nthreads)
+			fprintf(stderr, "warning: %d threads share %d CPUs\n",
+			        nthreads, ncpus);
+	}
+	gate_ready = gate_open = 0;
+	for (i = 0; i < nthreads; i++) {
+		w[i].cpu = ncpus ? cpus[i % ncpus] : -1;
+		w[i].pin_error = 0;
+		w[i].fn = fn;
+		w[i].h = h;
+		w[i].n = n;
+		w[i].want = want - h;
+		w[i].nd = nd;
+		w[i].private = private;
+		w[i].reps = reps;
+		if (pthread_create(&w[i].tid, NULL, work, &w[i])) {
+			fprintf(stderr, "cannot create thread %d\n", i);
+			exit(1);
+		}
+	}
+	pthread_mutex_lock(&gate_lock);
+	while (gate_ready < nthreads) pthread_cond_wait(&gate_cond, &gate_lock);
+	gate_open = 1;
+	t0 = now();
+	pthread_cond_broadcast(&gate_cond);
+	pthread_mutex_unlock(&gate_lock);
+	for (i = 0; i < nthreads; i++) {
+		pthread_join(w[i].tid, NULL);
+		bad |= w[i].bad;
+		if (w[i].pin_error && !warned++)
+			fprintf(stderr, "warning: cannot pin thread %d to CPU %d: %s\n",
+			        i, w[i].cpu, strerror(w[i].pin_error));
+		if (w[i].end > end) end = w[i].end;
+	}
+	return bad ? 0 : (double)n * reps * nthreads / (end - t0) / 1e9;
+}
+
+/* Return the throughput of fn in GB/s for haystack h of n bytes, or 0 if
+ * fn does not return want.  With the cache eviction buffer allocated only
+ * the calls themselves are timed, each starting from cold caches.
+ */
+static double measure(strstr_fn fn, const char *h, size_t n, const char *nd,
+                      const char *want, double mintime)
+{
+	unsigned long reps, i;
+	double t0, t;
+
+	if ((sink = fn(h, nd)) != want) return 0;
+	if (evict) {
+		for (reps = 0, t = 0; t < mintime || reps < 3; reps++) {
+			evict_caches();
+			t0 = now();
+			sink = fn(h, nd);
+			t += now() - t0;
+		}
+		return (double)n * reps / t / 1e9;
+	}
+	for (reps = 1;; reps *= 2) {
+		t0 = now();
+		for (i = 0; i < reps; i++) sink = fn(h, nd);
+		if ((t = now() - t0) >= mintime) break;
+	}
+	return (double)n * reps / t / 1e9;
+}
+
+/* Return the median of the n values at v, which are reordered. */
+static double median(double *v, int n)
+{
+	double t;
+	int i, j;
+
+	for (i = 1; i < n; i++)
+		for (j = i; j > 0 && v[j - 1] > v[j]; j--) {
+			t = v[j];
+			v[j] = v[j - 1];
+			v[j - 1] = t;
+		}
+	return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+/* Return the rate of the x86 time stamp counter in GHz, measured against
+ * the monotonic clock, or 0 where there is none.
+ */
+static double clock_ghz(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	unsigned long long c0;
+	double t0, t;
+
+	c0 = __rdtsc();
+	t0 = now();
+	while ((t = now()) - t0 < 0.1) ;
+	return (__rdtsc() - c0) / (t - t0) / 1e9;
+#else
+	return 0;
+#endif
+}
+
+/* Write s to f as a JSON string. */
+static void json_string(FILE *f, const char *s)
+{
+	putc('"', f);
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\') fprintf(f, "\\%c", *s);
+		else if ((unsigned char)*s < ' ') fprintf(f, "\\u%04x", *s);
+		else putc(*s, f);
+	}
+	putc('"', f);
+}
+
+/* Put the CPU's model name in buf. */
+static void cpu_model(char *buf, size_t size)
+{
+	size_t len = size;
+#ifdef __linux__
+	char line[256], *p;
+	FILE *f;
+
+	if ((f = fopen("/proc/cpuinfo", "r")) != NULL) {
+		while (fgets(line, sizeof line, f))
+			if (!strncmp(line, "model name", 10)
+					&& (p = strchr(line, ':')) != NULL) {
+				for (p++; *p == ' ' || *p == '\t'; p++) ;
+				p[strcspn(p, "\n")] = '\0';
+				snprintf(buf, size, "%s", p);
+				fclose(f);
+				return;
+			}
+		fclose(f);
+	}
+#elif defined(__APPLE__)
+	if (!sysctlbyname("machdep.cpu.brand_string", buf, &len, NULL, 0)) return;
+#elif defined(__FreeBSD__)
+	if (!sysctlbyname("hw.model", buf, &len, NULL, 0)) return;
+#endif
+	(void)len;
+	snprintf(buf, size, "unknown");
+}
+
+/* Write the rest of the "run" object: where and how the run was made. */
+static void write_run(FILE *f, int mode, int cold, double mintime,
+                      int nsamples, int nthreads, int private, double ghz)
+{
+	static const char *modes[] = { "find", "last", "count" };
+	struct utsname u;
+	char buf[256];
+	time_t t = time(NULL);
+
+	strftime(buf, sizeof buf, "%Y-%m-%dT%H:%M:%SZ", gmtime(&t));
+	fprintf(f, ",\"date\":\"%s\",\"cpu\":", buf);
+	cpu_model(buf, sizeof buf);
+	json_string(f, buf);
+	fprintf(f, ",\"compiler\":");
+#if defined(__GNUC__) && !defined(__clang__)
+	json_string(f, "gcc " __VERSION__);
+#elif defined(__VERSION__)
+	json_string(f, __VERSION__);
+#else
+	json_string(f, "unknown");
+#endif
+	fprintf(f, ",\"cflags\":");
+	json_string(f, STRSTR_CFLAGS);
+	if (!uname(&u)) {
+		snprintf(buf, sizeof buf, "%s %s %s", u.sysname, u.release, u.machine);
+		fprintf(f, ",\"os\":");
+		json_string(f, buf);
+	}
+	fprintf(f, ",\"corpus\":\"fill_haystack: xorshift32 lowercase words, "
+	        "seed 2463534242, needle planted at the %s\"",
+	        mode == LAST ? "start" : "end");
+	fprintf(f, ",\"mode\":\"%s\",\"cold\":%s,\"mintime\":%g,\"samples\":%d,"
+	        "\"threads\":%d,\"private\":%s,\"prefetch_distance\":%zu",
+	        modes[mode], cold ? "true" : "false", mintime, nsamples,
+	        nthreads, private ? "true" : "false", prefetch_distance);
+	if (ghz) fprintf(f, ",\"clock_ghz\":%.4f}\n", ghz);
+	else fprintf(f, ",\"clock_ghz\":null}\n");
+}
+
+/* Golden cases: the offsets of the first and last occurrence (-1 for
+ * none) and the number of occurrences, overlapping ones included.
+ */
+static const struct golden {
+	const char *h, *n;
+	int first, last, count;
+} golden[] = {
+	// empty strings
+	{ "", "", 0, 0, 1 },
+	{ "abc", "", 0, 3, 4 },
+	{ "", "a", -1, -1, 0 },
+	// needle equal to, longer than or at the end of the haystack
+	{ "abc", "abc", 0, 0, 1 },
+	{ "abc", "abcd", -1, -1, 0 },
+	{ "ab", "abc", -1, -1, 0 },
+	{ "aaa", "aaaa", -1, -1, 0 },
+	{ "hello", "o", 4, 4, 1 },
+	{ "hello", "h", 0, 0, 1 },
+	{ "hello", "z", -1, -1, 0 },
+	{ "abc", "c", 2, 2, 1 },
+	{ "abcd", "d\x01", -1, -1, 0 },
+	// overlapping prefixes and occurrences
+	{ "aaaa", "aa", 0, 2, 3 },
+	{ "abababc", "ababc", 2, 2, 1 },
+	{ "aabaabaaab", "aaab", 6, 6, 1 },
+	{ "abcabd", "abd", 3, 3, 1 },
+	{ "xyzxyz", "xyz", 0, 3, 2 },
+	{ "mississippi", "issi", 1, 4, 2 },
+	{ "mississippi", "issip", 4, 4, 1 },
+	{ "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab", "aaaaaaaaaaaaaaaaab",
+	  23, 23, 1 },
+	{ "abababababababababababababababababababababb", "ababb", 38, 38, 1 },
+	// bytes with the high bit set, negative as a signed char
+	{ "a\xe9" "b\xe9", "\xe9", 1, 3, 2 },
+	{ "x\xe9y", "\xe9", 1, 1, 1 },
+	{ "\xff\xfe\xff\xff", "\xff\xff", 2, 2, 1 },
+	{ "\x80" "abc\x80", "c\x80", 3, 3, 1 },
+	{ "\x7f\x80\x81", "\x80\x81", 1, 1, 1 },
+	{ "caf\xc3\xa9 cr\xc3\xa8me caf\xc3\xa9", "caf\xc3\xa9", 0, 13, 2 },
+	{ "\xe9\xe9\xe9\xe9\xe9\xe9\xe9\xe9\xe9\xe9\xe9\xe9\xe9\xe9\xe9\xe9"
+	  "\xe9\xe9\xe9\xe9", "\xe9\xe9\xe9", 0, 17, 18 },
+};
+
+#define NGOLDEN		(sizeof golden / sizeof golden[0])
+#define NGENERATED	2000
+#define NLONG		200
+#define NCASES		((int)(NGOLDEN + NGENERATED + NLONG))
+#define MAXHAY		12288   /* longest generated haystack */
+#define MAXNEEDLE	40      /* longest generated needle */
+
+/* strstrSimd.c searches windows of 4096 + m bytes that start this many
+ * bytes apart.
+ */
+#define SEAM		4097
+
+/* Work out g's answers for haystack h and needle n the slow way. */
+static void solve(struct golden *g, const char *h, size_t hl, const char *n,
+                  size_t nl)
+{
+	size_t k;
+
+	g->h = h;
+	g->n = n;
+	g->first = g->last = -1;
+	g->count = 0;
+	for (k = 0; k + nl <= hl; k++)
+		if (!memcmp(h + k, n, nl)) {
+			if (g->first < 0) g->first = (int)k;
+			g->last = (int)k;
+			g->count++;
+		}
+}
+
+static const char alpha[] = "ab\xe9\x80";
+
+#define NEXT	(x ^= x << 13, x &= 0xffffffffUL, x ^= x >> 17, \
+		 x ^= x << 5, x &= 0xffffffffUL)
+
+/* Make generated case i: up to 300 bytes from a small alphabet, so
+ * partial matches are common, and a needle of up to 40 bytes that is
+ * usually taken from the haystack.
+ */
+static void generate(int i, char *h, char *n, struct golden *g)
+{
+	static unsigned long x = 88675123UL;
+	size_t hl, nl, k, at;
+	int a;
+
+	if (!i) x = 88675123UL;
+	a = i % 3 ? 2 : 4;
+	hl = NEXT % 301;
+	for (k = 0; k < hl; k++) h[k] = alpha[NEXT % a];
+	h[hl] = '\0';
+	nl = NEXT % 41;
+	if (hl && NEXT % 4) {
+		at = NEXT % hl;
+		if (nl > hl - at) nl = hl - at;
+		memcpy(n, h + at, nl);
+		if (nl && NEXT % 3 == 0) n[nl - 1] = alpha[NEXT % a];
+	} else {
+		for (k = 0; k < nl; k++) n[k] = alpha[NEXT % a];
+	}
+	n[nl] = '\0';
+	solve(g, h, hl, n, nl);
+}
+
+/* Make long generated case i: 1K to 12K bytes, long enough for several
+ * of strstrSimd.c's windows and for strstrIndex.c's block minima and
+ * sparse table.  Every fourth needle is 1 to 4 bytes taken from the
+ * haystack, so it occurs all over it.  The others are random and so
+ * rarely occur by chance; one is planted straddling a window seam, at
+ * the very end or anywhere, often with all but its last byte just before.
+ */
+static void generate_long(int i, char *h, char *n, struct golden *g)
+{
+	static unsigned long x = 2463534242UL;
+	size_t hl, nl, k, at;
+	int a;
+
+	if (!i) x = 2463534242UL;
+	a = i % 3 ? 2 : 4;
+	hl = 1024 + NEXT % (MAXHAY - 1024 + 1);
+	for (k = 0; k < hl; k++) h[k] = alpha[NEXT % a];
+	h[hl] = '\0';
+	if (i % 4 == 0) {
+		nl = 1 + NEXT % 4;
+		memcpy(n, h + NEXT % (hl - nl + 1), nl);
+	} else {
+		nl = 2 + NEXT % (MAXNEEDLE - 1);
+		for (k = 0; k < nl; k++) n[k] = alpha[NEXT % a];
+		switch (NEXT % 3) {
+		case 0:
+			k = 1 + NEXT % ((hl - nl) / SEAM + 1);
+			at = k * SEAM - nl - 1 + NEXT % (nl + 4);
+			break;
+		case 1:
+			at = hl - nl;
+			break;
+		default:
+			at = NEXT % (hl - nl + 1);
+			break;
+		}
+		if (at > hl - nl) at = hl - nl;
+		memcpy(h + at, n, nl);
+		if (at >= nl && NEXT % 2) memcpy(h + at - nl, n, nl - 1);
+	}
+	n[nl] = '\0';
+	solve(g, h, hl, n, nl);
+}
+#undef NEXT
+
+/* Print string s with its unprintable bytes escaped. */
+static void show(const char *s)
+{
+	putchar('"');
+	for (; *s; s++)
+		if (*s >= ' ' && *s <= '~' && *s != '"' && *s != '\\') putchar(*s);
+		else printf("\\x%02x", (unsigned char)*s);
+	putchar('"');
+}
+
+/* Return the ends of two regions of MAXHAY + 2 * (MAXNEEDLE + 1) bytes,
+ * each followed by an inaccessible page, or NULL if there are none.
+ */
+static char *guard_pages(char **second)
+{
+	static char *end[2];
+	static int tried;
+	size_t page = (size_t)sysconf(_SC_PAGESIZE), span;
+	char *p;
+
+	if (!tried++) {
+		span = (MAXHAY + 2 * (MAXNEEDLE + 1) + page - 1) / page * page;
+		p = mmap(NULL, 2 * (span + page), PROT_READ | PROT_WRITE,
+		         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (p == MAP_FAILED || mprotect(p + span, page, PROT_NONE)
+				|| mprotect(p + 2 * span + page, page, PROT_NONE)) {
+			perror("guard pages");
+			return NULL;
+		}
+		end[0] = p + span;
+		end[1] = p + 2 * span + page;
+	}
+	*second = end[1];
+	return end[0];
+}
+
+/* Run im on haystack h and needle n, with g's answers; where says where
+ * they are.  Print the first few failures, bad being those so far, and
+ * return 1 for a failure, else 0.
+ */
+static int check(const struct impl *im, const struct golden *g,
+                 const char *h, const char *n, const char *where, int bad)
+{
+	const char *want, *got;
+
+	switch (im->mode) {
+	case LAST:   want = g->last < 0 ? NULL : h + g->last; break;
+	case COUNT:  want = h + g->count; break;
+	case EXISTS: want = h + (g->first >= 0); break;
+	default:     want = g->first < 0 ? NULL : h + g->first; break;
+	}
+	if (im->setup) im->setup(n);
+	if ((got = im->fn(h, n)) == want) return 0;
+	if (bad < 3) {
+		printf("  %s(", im->name);
+		show(h);
+		printf(", ");
+		show(n);
+		if (im->mode == COUNT || im->mode == EXISTS)
+			printf(") %s gave %td, want %td\n", where, got - h, want - h);
+		else
+			printf(") %s gave %td, want %td\n", where, got ? got - h : -1,
+			       want ? want - h : -1);
+	}
+	return 1;
+}
+
+/* Check implementation im on the golden and generated cases.  The
+ * haystack is laid out as  needle NUL haystack NUL needle NUL  so a search
+ * that starts before it or runs past its end finds a needle.  Each case
+ * is run again with the haystack's NUL, and separately the needle's, the
+ * last byte before an inaccessible page, so reading past either faults,
+ * and once more with each in a malloc'd block of its own size, so that
+ * AddressSanitizer reports reading past either at all.  Return the number
+ * of failed cases.
+ */
+static int verify(const struct impl *im)
+{
+	static char buf[MAXHAY + 3 * (MAXNEEDLE + 1)], hay[MAXHAY + 1];
+	char nd[MAXNEEDLE + 1], *gh, *gn, *mh, *mn;
+	struct golden g;
+	size_t hl, nl;
+	int i, bad = 0, wrong;
+
+	for (i = 0; i < NCASES; i++) {
+		if (i < (int)NGOLDEN) g = golden[i];
+		else if (i < (int)(NGOLDEN + NGENERATED))
+			generate(i - NGOLDEN, hay, nd, &g);
+		else generate_long(i - NGOLDEN - NGENERATED, hay, nd, &g);
+		hl = strlen(g.h);
+		nl = strlen(g.n);
+		memcpy(buf, g.n, nl + 1);
+		memcpy(buf + nl + 1, g.h, hl + 1);
+		memcpy(buf + nl + 1 + hl + 1, g.n, nl + 1);
+		wrong = check(im, &g, buf + nl + 1, buf, "between needles", bad);
+		if (!wrong && (gn = guard_pages(&gh)) != NULL) {
+			gh -= hl + 1;
+			gn -= nl + 1;
+			memcpy(gh - (nl + 1), g.n, nl + 1);
+			memcpy(gh, g.h, hl + 1);
+			memcpy(gn, g.n, nl + 1);
+			wrong = check(im, &g, gh, gn, "before guard pages", bad);
+		}
+		mh = malloc(hl + 1);
+		mn = malloc(nl + 1);
+		if (!wrong && mh && mn) {
+			memcpy(mh, g.h, hl + 1);
+			memcpy(mn, g.n, nl + 1);
+			wrong = check(im, &g, mh, mn, "in malloc'd blocks", bad);
+		}
+		free(mh);
+		free(mn);
+		bad += wrong;
+	}
+	printf("%s %s: %d of %d cases wrong\n", bad ? "FAIL" : "ok  ", im->name, bad,
+	       NCASES);
+	return bad;
+}
+
+/* Patterns strpat_compile must reject. */
+static const char *const bad_patterns[] = {
+	"a**", "(a", "a)", "*a", "(a)*", "[abc", "a\\", "((a)",
+};
+
+/* Patterns, the literals strpat_compile must extract from them (joined by
+ * '|'; empty if none can be required), and the match strpat_search must
+ * find in a string: start and end offsets, or -1 for none.
+ */
+static const struct pattern_case {
+	const char *pattern, *lits, *s;
+	int start, end;
+} pattern_cases[] = {
+	{ "foo.*bar", "foo", "xxfoo1bar2bar", 2, 13 },
+	{ "foo.*bar", "foo", "xxbar foo", -1, -1 },
+	{ "(GET|POST) /api", " /api", "POST /api/v1", 0, 9 },
+	{ "(GET|POST) /api", " /api", "PUT /api", -1, -1 },
+	{ "(GET|POST)x", "GET|POST", "a GETx", 2, 6 },
+	{ "(a|)b", "b", "cab", 1, 3 },
+	{ "(a|)b", "b", "cb", 1, 2 },
+	{ "a|", "", "xyz", 0, 0 },
+	{ "|", "", "", 0, 0 },
+	{ "a*b", "b", "caab", 1, 4 },
+	{ "x*", "", "abc", 0, 0 },
+	{ "[0-9][0-9]*", "", "ab123c", 2, 5 },
+	{ "[^a-z]", "", "abc1", 3, 4 },
+	{ "[^a-z]", "", "abc", -1, -1 },
+	{ "a|b", "a|b", "cb", 1, 2 },
+	{ "h.llo", "llo", "say hello", 4, 9 },
+	{ "\\.", ".", "a.b", 1, 2 },
+	{ "colou*r", "colo", "color", 0, 5 },
+	{ "(a|ab)c", "c", "abc", 0, 3 },
+	{ "a*a*a*b", "b", "aaaa", -1, -1 },
+	{ "[\xe0-\xef]", "", "caf\xe9", 3, 4 },
+	{ "caf\xe9", "caf\xe9", "un caf\xe9", 3, 7 },
+	{ "foo", "foo", "fo", -1, -1 },
+};
+
+/* Check strpat_compile and strpat_search on the cases above. */
+static int verify_patterns(void)
+{
+	const struct pattern_case *c;
+	char lits[STRPAT_LITBUF + STRPAT_MAXLITS];
+	const char *start, *end;
+	int i, k, bad = 0, n = 0;
+	strpat p;
+
+	for (i = 0; i < (int)(sizeof bad_patterns / sizeof bad_patterns[0]); i++) {
+		n++;
+		if (strpat_compile(&p, bad_patterns[i]) == 0) {
+			printf("  strpat_compile(");
+			show(bad_patterns[i]);
+			printf(") accepted a malformed pattern\n");
+			bad++;
+		}
+	}
+	for (i = 0; i < (int)(sizeof pattern_cases / sizeof pattern_cases[0]); i++) {
+		c = &pattern_cases[i];
+		n++;
+		if (strpat_compile(&p, c->pattern)) {
+			printf("  strpat_compile(");
+			show(c->pattern);
+			printf(") failed\n");
+			bad++;
+			continue;
+		}
+		for (lits[0] = '\0', k = 0; k < p.nlits; k++) {
+			if (k) strcat(lits, "|");
+			strcat(lits, p.litbuf + p.lit[k]);
+		}
+		end = NULL;
+		start = strpat_search(&p, c->s, &end);
+		if (strcmp(lits, c->lits) || (start ? start - c->s : -1) != c->start
+				|| (start ? end - c->s : -1) != c->end) {
+			printf("  strpat(");
+			show(c->pattern);
+			printf(", ");
+			show(c->s);
+			printf(") gave literals ");
+			show(lits);
+			printf(" match %td-%td, want ", start ? start - c->s : -1,
+			       start ? end - c->s : -1);
+			show(c->lits);
+			printf(" match %d-%d\n", c->start, c->end);
+			bad++;
+		}
+	}
+	printf("%s strpat_compile, strpat_search: %d of %d cases wrong\n",
+	       bad ? "FAIL" : "ok  ", bad, n);
+	return bad;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t minsize = 64, maxsize = (size_t)64 << 20;
+	size_t lens[MAXLENS] = { 1, 2, 4, 8, 16, 32, 64, 128, 256 };
+	size_t sel[NIMPLS], nsizes, size, n, m, i, k, at;
+	int nlens = 9, nsel = 0, gnuplot = 0, cold = 0, mode = FIND, opt;
+	int nthreads = 0, private = 0, check = 0, bad, nsamples = 1, j;
+	double mintime = 0.05, *gbps, *samples, *agg = NULL, ghz = 0;
+	char *h, saved[256], needle[257], end;
+	const char *json = NULL, *label = "";
+
+	while ((opt = getopt(argc, argv, "f:s:S:l:i:t:cE:p:RCT:Pr:j:L:G:v")) != -1) {
+		switch (opt) {
+		case 'f': gnuplot = !strcmp(optarg, "gnuplot"); break;
+		case 's': minsize = parse_size(optarg); break;
+		case 'S': maxsize = parse_size(optarg); break;
+		case 'l': nlens = parse_list(optarg, lens, MAXLENS); break;
+		case 'i': nsel = parse_list(optarg, sel, NIMPLS); break;
+		case 't': mintime = atof(optarg); break;
+		case 'c': cold = 1; break;
+		case 'E': evictsize = parse_size(optarg); break;
+		case 'p': prefetch_distance = parse_size(optarg); break;
+		case 'R': mode = LAST; break;
+		case 'C': mode = COUNT; break;
+		case 'T': nthreads = atoi(optarg); break;
+		case 'P': private = 1; break;
+		case 'r': nsamples = atoi(optarg); break;
+		case 'j': json = optarg; break;
+		case 'L': label = optarg; break;
+		case 'G': ghz = atof(optarg); break;
+		case 'v': check = 1; break;
+		default:
+			fprintf(stderr, "usage: %s [-f csv|gnuplot] [-s minsize] "
+			        "[-S maxsize] [-l lens] [-i impls] [-t secs] [-c] "
+			        "[-E evictsize] [-p distance] [-R | -C] "
+			        "[-T threads [-P]] [-r samples] "
+			        "[-j file [-L label] [-G ghz]]\n"
+			        "       %s -v [-i impls]\n", argv[0], argv[0]);
+			return 2;
+		}
+	}
+	if (!nsel)
+		for (i = 0; i < NIMPLS; i++)
+			if (impls[i].fn && (check || impls[i].mode == mode
+			                    || (mode == COUNT && impls[i].mode == EXISTS)))
+				sel[nsel++] = i;
+	for (i = 0; i < (size_t)nsel; i++) {
+		if (sel[i] >= NIMPLS || !impls[sel[i]].fn
+				|| (!check && impls[sel[i]].mode == INDEX)) {
+			fprintf(stderr, "no implementation %zu\n", sel[i]);
+			return 2;
+		}
+	}
+	for (i = 0; i < NIMPLS; i++)
+		if (!impls[i].name) impls[i].name = submitters[i];
+	if (check) {
+		for (bad = 0, i = 0; i < (size_t)nsel; i++)
+			bad += verify(&impls[sel[i]]) != 0;
+		bad += verify_patterns() != 0;
+		printf("%d of %d checks failed\n", bad, nsel + 1);
+		return bad != 0;
+	}
+	for (k = 0; k < (size_t)nlens; k++) {
+		if (lens[k] < 1 || lens[k] > 256) {
+			fprintf(stderr, "needle lengths must be 1 to 256\n");
+			return 2;
+		}
+	}
+	if (cold && nthreads > 0) {
+		fprintf(stderr, "-c and -T cannot be combined: the threads would "
+		        "run warm against a cold single-thread baseline\n");
+		return 2;
+	}
+	if (nsamples < 1 || nsamples > MAXSAMPLES) {
+		fprintf(stderr, "samples must be 1 to %d\n", MAXSAMPLES);
+		return 2;
+	}
+	if (minsize < 1) minsize = 1;
+	for (nsizes = 0, size = minsize; size <= maxsize; size *= 2) nsizes++;
+
+	if (!(h = malloc(maxsize + 1))
+			|| !(gbps = calloc(nsel * nsizes * nlens, sizeof *gbps))
+			|| !(samples = calloc(nsel * nsizes * nlens * nsamples,
+			                      sizeof *samples))) {
+		fprintf(stderr, "out of memory for %zu byte haystack\n", maxsize);
+		return 1;
+	}
+	if (nthreads > 0 && !(agg = calloc(nsel * nsizes * nlens, sizeof *agg))) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	fill_haystack(h, maxsize);
+	if (cold && !(evict = calloc(evictsize, 1))) {
+		fprintf(stderr, "out of memory for %zu byte eviction buffer\n",
+		        evictsize);
+		return 1;
+	}
+
+	for (n = 0, size = minsize; n < nsizes; n++, size *= 2) {
+		end = h[size];
+		h[size] = '\0';
+		for (k = 0; k < (size_t)nlens; k++) {
+			if ((m = lens[k]) > size) continue;
+			/* Plant the needle at the end of the haystack, or at the
+			 * start for -R.  Its last character is 'Z', which appears
+			 * nowhere else.
+			 */
+			at = mode == LAST ? 0 : size - m;
+			memcpy(saved, h + at, m);
+			h[at + m - 1] = 'Z';
+			memcpy(needle, h + at, m);
+			needle[m] = '\0';
+			for (i = 0; i < (size_t)nsel; i++) {
+				size_t r = (i * nsizes + n) * nlens + k;
+				const char *want =
+					impls[sel[i]].mode >= COUNT ? h + 1 : h + at;
+
+				if (impls[sel[i]].setup) impls[sel[i]].setup(needle);
+				for (j = 0; j < nsamples; j++)
+					samples[r * nsamples + j] = measure(impls[sel[i]].fn, h,
+						size, needle, want, mintime);
+				gbps[r] = median(samples + r * nsamples, nsamples);
+				if (!gbps[r])
+					fprintf(stderr, "%s: wrong result, size %zu, needle %zu\n",
+					        impls[sel[i]].name, size, m);
+				else if (agg)   // as many calls as one thread makes in mintime
+					agg[r] = measure_threads(impls[sel[i]].fn, h, size, needle,
+						want, 1 + mintime * gbps[r] * 1e9 / size, nthreads,
+						private);
+			}
+			memcpy(h + at, saved, m);
+		}
+		h[size] = end;
+	}
+
+	if (gnuplot) {
+		for (i = 0; i < (size_t)nsel; i++) {
+			if (i) printf("\n\n");
+			printf("# [%zu] %s\n# bytes", sel[i], impls[sel[i]].name);
+			for (k = 0; k < (size_t)nlens; k++) printf("\tm=%zu", lens[k]);
+			printf("\n");
+			for (n = 0, size = minsize; n < nsizes; n++, size *= 2) {
+				printf("%zu", size);
+				for (k = 0; k < (size_t)nlens; k++) {
+					if (lens[k] > size) printf("\t?");
+					else printf("\t%.4f", (agg ? agg : gbps)
+					                         [(i * nsizes + n) * nlens + k]);
+				}
+				printf("\n");
+			}
+		}
+	} else {
+		printf("impl,submitter,haystack_bytes,needle_len,gbps%s\n",
+		       agg ? ",threads,aggregate_gbps,efficiency" : "");
+		for (i = 0; i < (size_t)nsel; i++)
+			for (n = 0, size = minsize; n < nsizes; n++, size *= 2)
+				for (k = 0; k < (size_t)nlens; k++) {
+					size_t r = (i * nsizes + n) * nlens + k;
+
+					if (lens[k] > size) continue;
+					printf("%zu,\"%s\",%zu,%zu,%.4f", sel[i],
+					       impls[sel[i]].name, size, lens[k], gbps[r]);
+					if (agg)
+						printf(",%d,%.4f,%.3f", nthreads, agg[r], gbps[r]
+						       ? agg[r] / (nthreads * gbps[r]) : 0);
+					printf("\n");
+				}
+	}
+	if (json) {
+		FILE *f;
+
+		if (!ghz) ghz = clock_ghz();
+		if (!(f = fopen(json, "w"))) {
+			perror(json);
+			return 1;
+		}
+		fprintf(f, "{\"type\":\"run\",\"label\":");
+		json_string(f, label);
+		write_run(f, mode, cold, mintime, nsamples, nthreads, private, ghz);
+		for (i = 0; i < (size_t)nsel; i++)
+			for (n = 0, size = minsize; n < nsizes; n++, size *= 2)
+				for (k = 0; k < (size_t)nlens; k++) {
+					size_t r = (i * nsizes + n) * nlens + k;
+
+					if (lens[k] > size || !gbps[r]) continue;
+					fprintf(f, "{\"type\":\"result\",\"impl\":%zu,\"name\":",
+					        sel[i]);
+					json_string(f, impls[sel[i]].name);
+					fprintf(f, ",\"haystack_bytes\":%zu,\"needle_len\":%zu,"
+					        "\"gbps\":[", size, lens[k]);
+					for (j = 0; j < nsamples; j++)
+						fprintf(f, "%s%.6g", j ? "," : "",
+						        samples[r * nsamples + j]);
+					fprintf(f, "],\"median_gbps\":%.6g,\"cycles_per_byte\":",
+					        gbps[r]);
+					if (ghz) fprintf(f, "%.6g", ghz / gbps[r]);
+					else fprintf(f, "null");
+					if (agg)
+						fprintf(f, ",\"threads\":%d,\"aggregate_gbps\":%.6g",
+						        nthreads, agg[r]);
+					fprintf(f, "}\n");
+				}
+		if (fclose(f)) {
+			perror(json);
+			return 1;
+		}
+	}
+	free(agg);
+	free(evict);
+	free(samples);
+	free(gbps);
+	free(h);
+	return 0;
+}
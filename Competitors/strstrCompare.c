@@ -0,0 +1,390 @@
+/* strstrCompare.c - compare two strstrBench -j result files for
+ * performance regressions.
+ *
+ * This file is public domain per CC0 1.0, see
+ * https://creativecommons.org/publicdomain/mark/1.0/
+ *
+ * Each measurement (implementation, haystack size, needle length) found in
+ * both files is compared.  The change is that of the median GB/s; whether
+ * it is more than noise is decided by Welch's t-test on the samples, which
+ * does not assume the two runs are equally noisy.  A measurement is a
+ * regression if it is more than the threshold slower and the test's
+ * two-sided p-value is below alpha; with only one sample per measurement
+ * (strstrBench without -r) there is no test and the threshold alone
+ * decides.  The exit status is 1 if there is any regression, so a script
+ * or CI job can stop a change that costs 10% in strstr.c's hot loop:
+ *
+ *   ./strstrBench -r 7 -j old.json -L $(git rev-parse --short HEAD~1)
+ *   ./strstrBench -r 7 -j new.json -L $(git rev-parse --short HEAD)
+ *   ./strstrCompare old.json new.json
+ *
+ * Runs made with different settings (mode, -c, -T, -P, or -p where both
+ * time strstr_stream) measure different things, so they are refused, with
+ * exit status 2, unless -f is given.  A different number of samples only changes how much the
+ * test can tell, and is warned about.
+ *
+ * Build:  cc -O2 -o strstrCompare strstrCompare.c -lm
+ *
+ * Usage:  strstrCompare [-t percent] [-a alpha] [-f] [-v] old.json new.json
+ *
+ *   -t  smallest change reported, in percent (default 5)
+ *   -a  significance level (default 0.01)
+ *   -f  compare runs even if their settings differ
+ *   -v  print every measurement compared, not only the changes
+ */
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAXSAMPLES	100     /* as in strstrBench.c */
+#define MAXLINE		8192
+#define MAXNAME		128
+
+struct result {
+	char name[MAXNAME];
+	double size, len;
+	int n;                  /* samples */
+	double v[MAXSAMPLES];   /* GB/s */
+	double median;
+};
+
+/* The run settings compared, and whether runs must agree on them: always,
+ * or only if both have results for implementations named starting with
+ * only_for, the only ones the setting affects.
+ */
+static const struct setting {
+	const char *key;
+	int must_match;
+	const char *only_for;
+} settings[] = {
+	{ "mode", 1, NULL },
+	{ "cold", 1, NULL },
+	{ "threads", 1, NULL },
+	{ "private", 1, NULL },
+	{ "prefetch_distance", 1, "strstr_stream" },
+	{ "samples", 0, NULL },
+};
+
+#define NSETTINGS	(sizeof settings / sizeof settings[0])
+
+struct run {
+	char label[MAXNAME], cpu[MAXNAME], compiler[MAXNAME];
+	char setting[NSETTINGS][MAXNAME];       /* as written in the JSON */
+	struct result *r;
+	size_t n;
+};
+
+/* Find "key": in line and return what follows it, or NULL. */
+static const char *find(const char *line, const char *key)
+{
+	char pat[64];
+	const char *p;
+
+	snprintf(pat, sizeof pat, "\"%s\":", key);
+	return (p = strstr(line, pat)) != NULL ? p + strlen(pat) : NULL;
+}
+
+/* Copy the JSON string value of key in line to buf; return 0 or -1. */
+static int get_string(const char *line, const char *key, char *buf,
+                      size_t size)
+{
+	const char *p = find(line, key);
+	size_t i = 0;
+	unsigned v;
+	int k;
+
+	if (!p || *p++ != '"') return -1;
+	for (; *p && *p != '"'; p++) {
+		if (*p == '\\' && *++p == 'u') {
+			// exactly 4 hex digits, as strstrBench writes control bytes
+			for (v = 0, k = 1; k <= 4; k++) {
+				if (!isxdigit((unsigned char)p[k])) {
+					buf[i] = '\0';
+					return -1;
+				}
+				v = v * 16 + (isdigit((unsigned char)p[k]) ? p[k] - '0'
+				              : tolower((unsigned char)p[k]) - 'a' + 10);
+			}
+			buf[i] = (char)v;
+			p += 4;
+		} else if (!*p) {
+			break;
+		} else {
+			buf[i] = *p;
+		}
+		if (i + 1 < size) i++;
+	}
+	buf[i] = '\0';
+	return *p == '"' ? 0 : -1;
+}
+
+/* Copy the JSON value of key in line, as written, to buf; if the key is
+ * missing, as in files older than it, buf is empty.
+ */
+static void get_value(const char *line, const char *key, char *buf,
+                      size_t size)
+{
+	const char *p = find(line, key);
+	size_t i = 0;
+
+	if (p)
+		for (; *p && !strchr(",}\n", *p) && i + 1 < size; p++) buf[i++] = *p;
+	buf[i] = '\0';
+}
+
+static int get_number(const char *line, const char *key, double *v)
+{
+	const char *p = find(line, key);
+	char *end;
+
+	if (!p) return -1;
+	*v = strtod(p, &end);
+	return end == p ? -1 : 0;
+}
+
+static int by_key(const void *a, const void *b)
+{
+	const struct result *x = (const struct result *)a;
+	const struct result *y = (const struct result *)b;
+	int c = strcmp(x->name, y->name);
+
+	if (c) return c;
+	if (x->size != y->size) return x->size < y->size ? -1 : 1;
+	if (x->len != y->len) return x->len < y->len ? -1 : 1;
+	return 0;
+}
+
+static double median(const double *v, int n)
+{
+	double s[MAXSAMPLES], t;
+	int i, j;
+
+	memcpy(s, v, n * sizeof *s);
+	for (i = 1; i < n; i++)
+		for (j = i; j > 0 && s[j - 1] > s[j]; j--) {
+			t = s[j];
+			s[j] = s[j - 1];
+			s[j - 1] = t;
+		}
+	return n % 2 ? s[n / 2] : (s[n / 2 - 1] + s[n / 2]) / 2;
+}
+
+/* Read the run and results in file into *run; return 0 or -1. */
+static int load(const char *file, struct run *run)
+{
+	static char line[MAXLINE];
+	struct result *r;
+	size_t max = 0, i;
+	const char *p;
+	char *end;
+	FILE *f;
+
+	memset(run, 0, sizeof *run);
+	if (!(f = fopen(file, "r"))) {
+		perror(file);
+		return -1;
+	}
+	while (fgets(line, sizeof line, f)) {
+		if (!strchr(line, '\n') && !feof(f)) {
+			fprintf(stderr, "%s: line too long\n", file);
+			return -1;
+		}
+		if (strstr(line, "\"type\":\"run\"")) {
+			get_string(line, "label", run->label, MAXNAME);
+			get_string(line, "cpu", run->cpu, MAXNAME);
+			get_string(line, "compiler", run->compiler, MAXNAME);
+			for (i = 0; i < NSETTINGS; i++)
+				get_value(line, settings[i].key, run->setting[i], MAXNAME);
+			continue;
+		}
+		if (!strstr(line, "\"type\":\"result\"")) continue;
+		if (run->n == max) {
+			max = max ? 2 * max : 256;
+			if (!(r = realloc(run->r, max * sizeof *r))) {
+				fprintf(stderr, "out of memory\n");
+				return -1;
+			}
+			run->r = r;
+		}
+		r = &run->r[run->n];
+		if (get_string(line, "name", r->name, MAXNAME)
+				|| get_number(line, "haystack_bytes", &r->size)
+				|| get_number(line, "needle_len", &r->len)
+				|| !(p = find(line, "gbps")) || *p++ != '[') {
+			fprintf(stderr, "%s: bad result: %s", file, line);
+			return -1;
+		}
+		for (r->n = 0; r->n < MAXSAMPLES; r->n++, p = end + 1) {
+			r->v[r->n] = strtod(p, &end);
+			if (end == p) break;
+			if (*end != ',') {
+				r->n++;
+				break;
+			}
+		}
+		if (!r->n) {
+			fprintf(stderr, "%s: no samples: %s", file, line);
+			return -1;
+		}
+		r->median = median(r->v, r->n);
+		run->n++;
+	}
+	fclose(f);
+	qsort(run->r, run->n, sizeof *run->r, by_key);
+	return 0;
+}
+
+/* Does run have results for implementations named starting with prefix? */
+static int has_results(const struct run *run, const char *prefix)
+{
+	size_t i;
+
+	for (i = 0; i < run->n; i++)
+		if (!strncmp(run->r[i].name, prefix, strlen(prefix))) return 1;
+	return 0;
+}
+
+/* Continued fraction for the incomplete beta function, by the modified
+ * Lentz method.
+ */
+static double betacf(double a, double b, double x)
+{
+	double c = 1, d = 1 - (a + b) * x / (a + 1), h, aa, del;
+	int m;
+
+	if (fabs(d) < 1e-300) d = 1e-300;
+	h = d = 1 / d;
+	for (m = 1; m <= 300; m++) {
+		aa = m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m));
+		d = 1 + aa * d;
+		if (fabs(d) < 1e-300) d = 1e-300;
+		c = 1 + aa / c;
+		if (fabs(c) < 1e-300) c = 1e-300;
+		h *= (d = 1 / d) * c;
+		aa = -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1));
+		d = 1 + aa * d;
+		if (fabs(d) < 1e-300) d = 1e-300;
+		c = 1 + aa / c;
+		if (fabs(c) < 1e-300) c = 1e-300;
+		h *= del = (d = 1 / d) * c;
+		if (fabs(del - 1) < 1e-12) break;
+	}
+	return h;
+}
+
+/* The regularized incomplete beta function I_x(a, b). */
+static double ibeta(double a, double b, double x)
+{
+	double bt;
+
+	if (x <= 0) return 0;
+	if (x >= 1) return 1;
+	bt = exp(lgamma(a + b) - lgamma(a) - lgamma(b)
+	         + a * log(x) + b * log(1 - x));
+	if (x < (a + 1) / (a + b + 2)) return bt * betacf(a, b, x) / a;
+	return 1 - bt * betacf(b, a, 1 - x) / b;
+}
+
+/* Return the two-sided p-value of Welch's t-test on samples x and y, each
+ * of at least two values.
+ */
+static double welch(const double *x, int nx, const double *y, int ny)
+{
+	double mx = 0, my = 0, vx = 0, vy = 0, sx, sy, t, df;
+	int i;
+
+	for (i = 0; i < nx; i++) mx += x[i] / nx;
+	for (i = 0; i < ny; i++) my += y[i] / ny;
+	for (i = 0; i < nx; i++) vx += (x[i] - mx) * (x[i] - mx) / (nx - 1);
+	for (i = 0; i < ny; i++) vy += (y[i] - my) * (y[i] - my) / (ny - 1);
+	sx = vx / nx;
+	sy = vy / ny;
+	if (sx + sy == 0) return mx == my ? 1 : 0;
+	t = (mx - my) / sqrt(sx + sy);
+	df = (sx + sy) * (sx + sy) / (sx * sx / (nx - 1) + sy * sy / (ny - 1));
+	return ibeta(df / 2, 0.5, df / (df + t * t));
+}
+
+int main(int argc, char *argv[])
+{
+	double threshold = 5, alpha = 0.01, change, p;
+	size_t i, compared = 0, worse = 0, better = 0;
+	struct result *o, *r;
+	struct run old, new;
+	const char *flag;
+	int opt, all = 0, force = 0, differ = 0, must;
+
+	while ((opt = getopt(argc, argv, "t:a:fv")) != -1) {
+		switch (opt) {
+		case 't': threshold = atof(optarg); break;
+		case 'a': alpha = atof(optarg); break;
+		case 'f': force = 1; break;
+		case 'v': all = 1; break;
+		default: goto usage;
+		}
+	}
+	if (argc - optind != 2) {
+usage:
+		fprintf(stderr, "usage: %s [-t percent] [-a alpha] [-f] [-v] "
+		        "old.json new.json\n", argv[0]);
+		return 2;
+	}
+	if (load(argv[optind], &old) || load(argv[optind + 1], &new)) return 2;
+	printf("old: %s  %s  %s\nnew: %s  %s  %s\n", old.label, old.cpu,
+	       old.compiler, new.label, new.cpu, new.compiler);
+	if (strcmp(old.cpu, new.cpu))
+		printf("warning: the runs were made on different CPUs\n");
+	for (i = 0; i < NSETTINGS; i++) {
+		if (!strcmp(old.setting[i], new.setting[i])) continue;
+		must = settings[i].must_match && (!settings[i].only_for
+			|| (has_results(&old, settings[i].only_for)
+			    && has_results(&new, settings[i].only_for)));
+		printf("%s: the runs were made with %s %s and %s\n",
+		       must && !force ? "error" : "warning",
+		       settings[i].key, *old.setting[i] ? old.setting[i] : "unknown",
+		       *new.setting[i] ? new.setting[i] : "unknown");
+		differ |= must;
+	}
+	if (differ && !force) {
+		fprintf(stderr, "the runs measured different things; "
+		        "compare them anyway with -f\n");
+		free(old.r);
+		free(new.r);
+		return 2;
+	}
+	printf("%-32s %10s %4s %9s %9s %8s %8s\n", "implementation", "bytes",
+	       "len", "old GB/s", "new GB/s", "change", "p");
+
+	for (i = 0; i < new.n; i++) {
+		r = &new.r[i];
+		if (!(o = bsearch(r, old.r, old.n, sizeof *o, by_key))) continue;
+		compared++;
+		change = 100 * (r->median - o->median) / o->median;
+		p = o->n > 1 && r->n > 1 ? welch(o->v, o->n, r->v, r->n) : -1;
+		flag = "";
+		if (fabs(change) > threshold && p < alpha) {
+			if (change < 0) {
+				flag = "REGRESSION";
+				worse++;
+			} else {
+				flag = "improvement";
+				better++;
+			}
+		}
+		if (!all && !*flag) continue;
+		printf("%-32.32s %10.0f %4.0f %9.4f %9.4f %+7.1f%% ", r->name,
+		       r->size, r->len, o->median, r->median, change);
+		if (p < 0) printf("%8s %s\n", "-", flag);
+		else printf("%8.2g %s\n", p, flag);
+	}
+	printf("%zu measurements compared, %zu regressions, %zu improvements "
+	       "(threshold %g%%, alpha %g)\n", compared, worse, better,
+	       threshold, alpha);
+	free(old.r);
+	free(new.r);
+	return worse != 0;
+}
@@ -0,0 +1,135 @@
+/* Date: 2026-10-19
+ * This file is public domain per CC0 1.0, see
+ * https://creativecommons.org/publicdomain/mark/1.0/
+ *
+ * Declarations for the search functions that accompany strstr.c.  strstr
+ * itself is declared by <string.h>.
+ */
+
+#ifndef STRSTR_H
+#define STRSTR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------(strstrStream.c)-----------------------------*/
+
+/* Bytes ahead of the scan position that strstr_stream prefetches. */
+#define STRSTR_PREFETCH_DISTANCE	1024
+
+char *strstr_stream(const char *s1, const char *s2);
+char *strstr_stream_ex(const char *s1, const char *s2, size_t dist, int nta);
+
+/*---------------------------(strstrPattern.c)----------------------------*/
+
+#define STRPAT_MAXNODES		64
+#define STRPAT_MAXCLASSES	8
+#define STRPAT_MAXLITS		8
+#define STRPAT_LITBUF		128
+
+/* A compiled pattern.  Everything lives inside the structure, so a strpat
+ * may be declared on the stack or statically; nothing is ever allocated.
+ */
+typedef struct strpat {
+	struct strpat_node {
+		unsigned char type, c, star;
+		signed char next, sub, alt;
+	} node[STRPAT_MAXNODES];
+	unsigned char cls[STRPAT_MAXCLASSES][32];
+	unsigned char lit[STRPAT_MAXLITS];      /* offsets into litbuf */
+	char litbuf[STRPAT_LITBUF];
+	int nnodes, nclasses, nlits;
+} strpat;
+
+int strpat_compile(strpat *p, const char *pattern);
+const char *strpat_search(const strpat *p, const char *s, const char **end);
+
+/*---------------------------(strstrPrepared.c)---------------------------*/
+
+/* A needle prepared for repeated searches.  It is built in memory the
+ * caller supplies, strstr_prepare_size(needle) bytes aligned like a size_t,
+ * and is followed in that memory by the needle text.
+ */
+typedef struct strstr_needle {
+	size_t len;
+	unsigned char skip[256];
+	char text[1];
+} strstr_needle;
+
+/* Caller-supplied memory that prepared needles are packed into. */
+typedef struct strstr_arena {
+	char *base;
+	size_t size, used;
+} strstr_arena;
+
+size_t strstr_prepare_size(const char *needle);
+strstr_needle *strstr_prepare(void *mem, size_t size, const char *needle);
+void strstr_arena_init(strstr_arena *a, void *mem, size_t size);
+strstr_needle *strstr_arena_prepare(strstr_arena *a, const char *needle);
+char *strstr_prepared(const char *s1, const strstr_needle *n);
+
+/*---------------------------(strstrReverse.c)----------------------------*/
+
+char *strrstr(const char *s1, const char *s2);
+void *memrmem(const void *h, size_t hl, const void *n, size_t nl);
+void *memrmem_scalar(const void *h, size_t hl, const void *n, size_t nl);
+void *memrmem_horspool(const void *h, size_t hl, const void *n, size_t nl);
+#ifdef __SSE2__
+void *memrmem_sse2(const void *h, size_t hl, const void *n, size_t nl);
+#endif
+
+/*---------------------------(strstrSimd.c)-------------------------------*/
+
+char *strstr_simd(const char *s1, const char *s2);
+size_t strstr_count(const char *s1, const char *s2);
+char *strstr_short(const char *s1, const char *s2);
+int strcontains(const char *s1, const char *s2);
+#ifdef __SSE2__
+char *strstr_sse2(const char *s1, const char *s2);
+#endif
+#ifdef __aarch64__
+char *strstr_neon(const char *s1, const char *s2);
+#ifdef __ARM_FEATURE_SVE
+char *strstr_sve(const char *s1, const char *s2);
+#endif
+#endif
+
+/*---------------------------(strstrIndex.c)------------------------------*/
+
+/* An index of one haystack; the arrays follow it at the offsets given. */
+typedef struct strstr_index {
+	char magic[8];
+	uint32_t version, byteorder;
+	uint64_t size;          /* bytes in the whole index */
+	uint64_t n;             /* haystack length */
+	uint64_t nsuper, levels;        /* sparse table dimensions */
+	uint64_t sa, bmin, st, text;    /* offsets from the start of the index */
+} strstr_index;
+
+size_t strstr_index_size(size_t n);
+size_t strstr_index_scratch_size(size_t n);
+strstr_index *strstr_index_build(void *mem, size_t size, const char *s,
+                                 void *scratch);
+const strstr_index *strstr_index_attach(const void *mem, size_t size);
+char *strstr_indexed(const strstr_index *ix, const char *s2);
+
+/*---------------------------(strstrUring.c)------------------------------*/
+
+#ifdef __linux__
+typedef void (*strstr_uring_fn)(void *arg, size_t file, long long offset,
+                                int err);
+size_t strstr_uring_memsize(size_t bufsize, unsigned nbufs);
+int strstr_uring_search(const char *const *paths, size_t npaths,
+                        const char *needle, void *mem, size_t bufsize,
+                        unsigned nbufs, strstr_uring_fn done, void *arg);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STRSTR_H */
@@ -0,0 +1,396 @@
+/* Date: 2026-10-19
+ * This file is public domain per CC0 1.0, see
+ * https://creativecommons.org/publicdomain/mark/1.0/
+ *
+ * A suffix array index for searching one static haystack many times, such
+ * as a dictionary or mobyThesaurus.txt.
+ *
+ * strstr_index_build sorts the haystack's suffixes once, in O(n log n)
+ * time.  strstr_indexed then answers the same question as strstr: where
+ * the first (leftmost) occurrence of a string is.  Two binary searches
+ * find the range of suffixes that start with the needle, in O(m log n)
+ * time with the usual trick of skipping the bytes already known to match
+ * at both ends of the range (so repeated prefixes are not re-compared).
+ * The smallest position in that range is the leftmost occurrence; a table
+ * of minima over blocks of 32 and a sparse table over blocks of 1024 find
+ * it after reading at most 126 entries, however common the needle is.
+ *
+ * The index is one position independent block of memory: a header, the
+ * arrays and a copy of the haystack, at offsets recorded in the header.
+ * It can be written to a file as is and later used straight from an mmap
+ * of the file, after strstr_index_attach checks the header.  As in
+ * strstrPrepared.c, nothing is allocated: the caller supplies the index's
+ * memory, strstr_index_size(n) bytes, and the memory for building it,
+ * strstr_index_scratch_size(n) bytes.  Haystacks are limited to less than
+ * 4 GiB because positions are stored in 32 bits, which halves the index.
+ *
+ * Compiled with -DSTRSTR_INDEX_MAIN this file is also a program that
+ * builds an index file, or compares its queries with strstr:
+ *
+ *   cc -O2 -DSTRSTR_INDEX_MAIN -o strstrIndex strstrIndex.c strstr.c
+ *   strstrIndex build haystack index
+ *   strstrIndex query index needle...
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "strstr.h"
+
+#define ALIGN(n)	(((n) + sizeof(uint64_t) - 1) & ~(uint64_t)(sizeof(uint64_t) - 1))
+
+#define MAGIC		"STRSTRIX"
+#define VERSION		1
+#define BYTEORDER	0x01020304u     /* reads differently if byte-swapped */
+#define BLOCK		32              /* suffix array entries per minimum */
+#define SUPER		(BLOCK * BLOCK) /* entries per sparse table minimum */
+
+/* Fill in ix's sizes and offsets for a haystack of n bytes.  They are
+ * worked out in 64 bits, which cannot overflow for n below 4 GiB, even
+ * where a size_t is 32 bits and the index does not fit in one.
+ */
+static void layout(strstr_index *ix, uint64_t n)
+{
+	uint64_t levels = 0;
+
+	while (((uint64_t)1 << levels) <= n / SUPER) levels++;
+	ix->n = n;
+	ix->nsuper = n / SUPER;
+	ix->levels = levels;
+	ix->sa = ALIGN(sizeof *ix);
+	ix->bmin = ix->sa + ALIGN(n * sizeof(uint32_t));
+	ix->st = ix->bmin + ALIGN(n / BLOCK * sizeof(uint32_t));
+	ix->text = ix->st + ALIGN(levels * (n / SUPER) * sizeof(uint32_t));
+	ix->size = ix->text + ALIGN(n + 1);
+}
+
+/* strstr_index_size returns the bytes of memory an index of a haystack of
+ * n bytes occupies, about 5.2 n, or 0 if that is more than a size_t holds
+ * or n is 4 GiB or more.
+ */
+size_t strstr_index_size(size_t n)
+{
+	strstr_index ix;
+
+	if ((uint64_t)n >= UINT32_MAX) return 0;
+	layout(&ix, n);
+	return ix.size > SIZE_MAX ? 0 : (size_t)ix.size;
+}
+
+/* strstr_index_scratch_size returns the bytes of scratch memory that
+ * strstr_index_build needs for a haystack of n bytes, about 12 n, or 0 if
+ * that is more than a size_t holds or n is 4 GiB or more.
+ */
+size_t strstr_index_scratch_size(size_t n)
+{
+	uint64_t size;
+
+	if ((uint64_t)n >= UINT32_MAX) return 0;
+	size = (2 * (uint64_t)n + (n > 256 ? n : 256) + 1) * sizeof(uint32_t);
+	return size > SIZE_MAX ? 0 : (size_t)size;
+}
+
+/* Sort the suffixes of the n bytes at t into sa by prefix doubling: after
+ * the pass for k, rk ranks the suffixes by their first 2k bytes.  Each
+ * pass is a radix sort on (rank of the first k bytes, rank of the next k),
+ * with rank 0 for "past the end".
+ */
+static void suffix_sort(const unsigned char *t, uint32_t n, uint32_t *sa,
+                        uint32_t *rk, uint32_t *tmp, uint32_t *cnt)
+{
+	uint32_t i, j, r, maxr = 256;
+	uint64_t a, b, k;       /* a + k and 2 * k pass 4G for n above 2G */
+
+	for (i = 0; i < n; i++) rk[i] = t[i] + 1;
+	for (k = 0;; k = k ? 2 * k : 1) {
+		if (k) {
+			// order by the second key, then stable sort on the first
+			j = 0;
+			for (i = k < n ? (uint32_t)(n - k) : 0; i < n; i++) tmp[j++] = i;
+			for (i = 0; i < n; i++)
+				if (sa[i] >= k) tmp[j++] = (uint32_t)(sa[i] - k);
+		} else {
+			for (i = 0; i < n; i++) tmp[i] = i;
+		}
+		memset(cnt, 0, (maxr + 1) * sizeof *cnt);
+		for (i = 0; i < n; i++) cnt[rk[i]]++;
+		for (i = 1; i <= maxr; i++) cnt[i] += cnt[i - 1];
+		for (i = n; i-- > 0;) sa[--cnt[rk[tmp[i]]]] = tmp[i];
+
+		tmp[sa[0]] = r = 1;
+		for (i = 1; i < n; i++) {
+			a = sa[i - 1];
+			b = sa[i];
+			if (rk[a] != rk[b] || (k && (a + k < n ? rk[a + k] : 0)
+					!= (b + k < n ? rk[b + k] : 0)))
+				r++;
+			tmp[b] = r;
+		}
+		memcpy(rk, tmp, n * sizeof *rk);
+		maxr = r;
+		if (maxr == n) return;
+	}
+}
+
+/* strstr_index_build builds an index of string s in the size bytes at mem,
+ * which must be aligned like a uint64_t, using the memory at scratch,
+ * aligned like a size_t.  It returns the index, or a NULL pointer if mem
+ * is misaligned or smaller than strstr_index_size(strlen(s)), or s is
+ * 4 GiB or longer, or the index or its scratch memory would be larger than
+ * a size_t can count.
+ */
+strstr_index *strstr_index_build(void *mem, size_t size, const char *s,
+                                 void *scratch)
+{
+	strstr_index *ix = (strstr_index *)mem;
+	size_t n = strlen(s), i, j, nb;
+	uint32_t *sa, *bmin, *st, *tmp = (uint32_t *)scratch, v;
+
+	if ((uintptr_t)mem % sizeof(uint64_t) || !strstr_index_size(n)
+			|| !strstr_index_scratch_size(n) || size < strstr_index_size(n))
+		return NULL;
+
+	memcpy(ix->magic, MAGIC, sizeof ix->magic);
+	ix->version = VERSION;
+	ix->byteorder = BYTEORDER;
+	layout(ix, n);
+	sa = (uint32_t *)((char *)ix + ix->sa);
+	bmin = (uint32_t *)((char *)ix + ix->bmin);
+	st = (uint32_t *)((char *)ix + ix->st);
+	memcpy((char *)ix + ix->text, s, n + 1);
+	if (n) suffix_sort((const unsigned char *)s, (uint32_t)n, sa, tmp,
+	                   tmp + n, tmp + 2 * n);
+
+	// minima of whole blocks, then of whole superblocks and their powers of 2
+	for (i = 0, nb = n / BLOCK; i < nb; i++)
+		for (bmin[i] = sa[i * BLOCK], j = 1; j < BLOCK; j++)
+			if (sa[i * BLOCK + j] < bmin[i]) bmin[i] = sa[i * BLOCK + j];
+	for (i = 0; i < ix->nsuper; i++)
+		for (st[i] = bmin[i * BLOCK], j = 1; j < BLOCK; j++)
+			if (bmin[i * BLOCK + j] < st[i]) st[i] = bmin[i * BLOCK + j];
+	for (j = 1; j < ix->levels; j++)
+		for (i = 0; i + ((size_t)1 << j) <= ix->nsuper; i++) {
+			v = st[(j - 1) * ix->nsuper + i + ((size_t)1 << (j - 1))];
+			st[j * ix->nsuper + i] = st[(j - 1) * ix->nsuper + i] < v
+				? st[(j - 1) * ix->nsuper + i] : v;
+		}
+	return ix;
+}
+
+/* strstr_index_attach returns the index in the size bytes at mem, such as
+ * an mmap of a file an index was written to, or a NULL pointer if mem is
+ * misaligned or does not hold an index built by this version for a machine
+ * of this byte order.  Only the header is checked, not the arrays.
+ */
+const strstr_index *strstr_index_attach(const void *mem, size_t size)
+{
+	const strstr_index *ix = (const strstr_index *)mem;
+	strstr_index want;
+
+	if ((uintptr_t)mem % sizeof(uint64_t) || size < sizeof *ix
+			|| memcmp(ix->magic, MAGIC, sizeof ix->magic)
+			|| ix->version != VERSION || ix->byteorder != BYTEORDER
+			|| ix->n >= UINT32_MAX || ix->size > size)
+		return NULL;
+	layout(&want, ix->n);
+	if (ix->size != want.size || ix->sa != want.sa || ix->bmin != want.bmin
+			|| ix->st != want.st || ix->text != want.text
+			|| ix->nsuper != want.nsuper || ix->levels != want.levels
+			|| ((const char *)ix + ix->text)[ix->n] != '\0')
+		return NULL;
+	return ix;
+}
+
+/* Compare the m bytes of needle t with suffix s, given their first *l bytes
+ * match; set *l to the bytes that match.  The haystack's NUL sorts first.
+ */
+static int compare(const unsigned char *s, const unsigned char *t, size_t m,
+                   size_t *l)
+{
+	size_t i = *l;
+
+	while (i < m && s[i] == t[i]) i++;
+	*l = i;
+	return i == m ? 0 : s[i] - t[i];
+}
+
+#define MIN(x)	do { if ((x) < v) v = (x); } while (0)
+
+/* Return the smallest suffix array entry in [lo, hi). */
+static uint32_t range_min(const strstr_index *ix, size_t lo, size_t hi)
+{
+	const uint32_t *sa = (const uint32_t *)((const char *)ix + ix->sa);
+	const uint32_t *bmin = (const uint32_t *)((const char *)ix + ix->bmin);
+	const uint32_t *st = (const uint32_t *)((const char *)ix + ix->st);
+	uint32_t v = UINT32_MAX;
+	size_t k;
+
+	for (; lo < hi && lo % BLOCK; lo++) MIN(sa[lo]);
+	for (; hi > lo && hi % BLOCK; hi--) MIN(sa[hi - 1]);
+	lo /= BLOCK;
+	hi /= BLOCK;
+	for (; lo < hi && lo % BLOCK; lo++) MIN(bmin[lo]);
+	for (; hi > lo && hi % BLOCK; hi--) MIN(bmin[hi - 1]);
+	lo /= BLOCK;
+	hi /= BLOCK;
+	if (lo < hi) {
+		for (k = 0; ((size_t)2 << k) <= hi - lo; k++) ;
+		MIN(st[k * ix->nsuper + lo]);
+		MIN(st[k * ix->nsuper + hi - ((size_t)1 << k)]);
+	}
+	return v;
+}
+
+/* strstr_indexed returns a pointer to the first occurrence of string s2 in
+ * the haystack copy held by index ix, or a NULL pointer if s2 does not
+ * occur in it.  It returns the start of the copy if s2 is a zero length
+ * string.
+ */
+char *strstr_indexed(const strstr_index *ix, const char *s2)
+{
+	const unsigned char *t = (const unsigned char *)ix + ix->text;
+	const unsigned char *n = (const unsigned char *)s2;
+	const uint32_t *sa = (const uint32_t *)((const char *)ix + ix->sa);
+	size_t m = strlen(s2), lo = 0, hi = (size_t)ix->n, first, mid, l, ll, rl;
+
+	if (!m) return (char *)t;
+
+	// first suffix not less than s2; [lo, hi) lies between suffixes that
+	// match s2 for ll and rl bytes, so all of it matches for min(ll, rl)
+	for (ll = rl = 0; lo < hi;) {
+		mid = lo + (hi - lo) / 2;
+		l = ll < rl ? ll : rl;
+		if (compare(t + sa[mid], n, m, &l) < 0) {
+			lo = mid + 1;
+			ll = l;
+		} else {
+			hi = mid;
+			rl = l;
+		}
+	}
+	l = 0;
+	if (lo == ix->n || compare(t + sa[lo], n, m, &l)) return NULL;
+
+	// first suffix after lo that does not start with s2
+	first = lo++;
+	for (ll = m, rl = 0, hi = (size_t)ix->n; lo < hi;) {
+		mid = lo + (hi - lo) / 2;
+		l = ll < rl ? ll : rl;
+		if (compare(t + sa[mid], n, m, &l) == 0) {
+			lo = mid + 1;
+			ll = l;
+		} else {
+			hi = mid;
+			rl = l;
+		}
+	}
+	return (char *)t + range_min(ix, first, lo);
+}
+
+#ifdef STRSTR_INDEX_MAIN
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int build(const char *in, const char *out)
+{
+	void *mem, *scratch;
+	strstr_index *ix;
+	char *s;
+	long len;
+	FILE *f;
+
+	if (!(f = fopen(in, "rb")) || fseek(f, 0, SEEK_END)
+			|| (len = ftell(f)) < 0 || fseek(f, 0, SEEK_SET)) {
+		perror(in);
+		return 1;
+	}
+	if (!(s = malloc(len + 1))
+			|| !(mem = malloc(strstr_index_size(len)))
+			|| !(scratch = malloc(strstr_index_scratch_size(len)))) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	s[fread(s, 1, len, f)] = '\0';   // the index ends at any NUL
+	fclose(f);
+	if (!(ix = strstr_index_build(mem, strstr_index_size(len), s, scratch))) {
+		fprintf(stderr, "%s: too big to index\n", in);
+		return 1;
+	}
+	if (!(f = fopen(out, "wb")) || fwrite(ix, 1, ix->size, f) != ix->size
+			|| fclose(f)) {
+		perror(out);
+		return 1;
+	}
+	printf("%llu bytes indexed in %llu bytes\n",
+	       (unsigned long long)ix->n, (unsigned long long)ix->size);
+	return 0;
+}
+
+static int query(const char *file, char **needles, int count)
+{
+	const strstr_index *ix;
+	const char *text, *p, *q;
+	double t, ti, ts;
+	struct stat st;
+	long reps, r;
+	void *mem;
+	int fd, i, bad = 0;
+
+	t = now();
+	if ((fd = open(file, O_RDONLY)) < 0 || fstat(fd, &st) < 0
+			|| (mem = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0))
+				== MAP_FAILED) {
+		perror(file);
+		return 1;
+	}
+	if (!(ix = strstr_index_attach(mem, st.st_size))) {
+		fprintf(stderr, "%s: not an index\n", file);
+		return 1;
+	}
+	printf("attached in %.6f s\n", now() - t);
+	text = (const char *)ix + ix->text;
+
+	for (i = 0; i < count; i++) {
+		p = strstr_indexed(ix, needles[i]);
+		q = strstr(text, needles[i]);
+		if (p != q) bad = 1;
+		reps = 1;
+		do {
+			reps *= 2;
+			t = now();
+			for (r = 0; r < reps; r++) p = strstr_indexed(ix, needles[i]);
+			ti = (now() - t) / reps;
+		} while (ti * reps < 0.05);
+		t = now();
+		q = strstr(text, needles[i]);
+		ts = now() - t;
+		printf("%-20s offset %-10lld index %10.3f us  strstr %10.3f us%s\n",
+		       needles[i], p ? (long long)(p - text) : -1LL, ti * 1e6,
+		       ts * 1e6, p == q ? "" : "  MISMATCH");
+	}
+	return bad;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc == 4 && !strcmp(argv[1], "build")) return build(argv[2], argv[3]);
+	if (argc >= 4 && !strcmp(argv[1], "query"))
+		return query(argv[2], argv + 3, argc - 3);
+	fprintf(stderr, "usage: %s build haystack index\n"
+	        "       %s query index needle...\n", argv[0], argv[0]);
+	return 2;
+}
+#endif
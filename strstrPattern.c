@@ -0,0 +1,313 @@
+/* Date: 2026-10-19
+ * This file is public domain per CC0 1.0, see
+ * https://creativecommons.org/publicdomain/mark/1.0/
+ *
+ * A regex-lite pattern matcher that uses strstr as a prefilter.
+ *
+ * Syntax:  c        the character c
+ *          \c       the character c, even if special
+ *          .        any character
+ *          [abc]    any of a, b or c; ranges such as [a-z] and negation
+ *                   such as [^0-9] are allowed
+ *          x*       zero or more of x, where x is one of the above
+ *          (a|b)    a or b; groups nest and may not be starred
+ *          a|b      a or b for the whole pattern
+ *
+ * Matches may start anywhere in the string searched, as with strstr.
+ *
+ * strpat_compile extracts the literals some one of which must be present
+ * in any string the pattern matches: "foo.*bar" requires "foo" (or "bar",
+ * equally long); "(GET|POST) /api" requires " /api".  strpat_search first
+ * looks for those literals with strstr and runs the backtracking matcher
+ * only on strings that contain one, so most non-matching strings (e.g.
+ * log lines) cost no more than a strstr call or two.
+ *
+ * The matcher backtracks, so its time is exponential in the number of
+ * adjacent stars that can match the same characters: a*a*a*a*b tries
+ * every way of splitting a run of a's between its four stars before it
+ * gives up on a string such as "aaa...ac b".  Patterns from untrusted
+ * sources should be limited in length or in the stars they may use.
+ */
+
+#include <string.h>
+#include "strstr.h"
+
+#define STRPAT_MAXLIT	(STRPAT_LITBUF / STRPAT_MAXLITS - 1)
+
+enum { GROUP, BRANCH, CHAR, ANY, CLASS };
+
+struct lits {
+	int n;
+	struct { signed char node; unsigned char len; } l[STRPAT_MAXLITS];
+};
+
+/* continuation: where to carry on when a group's branch has matched */
+struct cont {
+	int node;
+	const struct cont *up;
+};
+
+static int parse_alt(strpat *p, const char **ps);
+
+static int new_node(strpat *p, int type)
+{
+	struct strpat_node *nd;
+
+	if (p->nnodes == STRPAT_MAXNODES) return -1;
+	nd = &p->node[p->nnodes];
+	nd->type = type;
+	nd->c = nd->star = 0;
+	nd->next = nd->sub = nd->alt = -1;
+	return p->nnodes++;
+}
+
+/* Parse a bracket expression after its '['; return its class number. */
+static int parse_class(strpat *p, const char **ps)
+{
+	const unsigned char *s = (const unsigned char *)*ps;
+	unsigned char *set;
+	int negate, lo, hi, i;
+
+	if (p->nclasses == STRPAT_MAXCLASSES) return -1;
+	set = p->cls[p->nclasses];
+	memset(set, 0, 32);
+	if ((negate = (*s == '^'))) s++;
+	for (i = 0; *s && (*s != ']' || !i); i++) {
+		if (*s == '\\' && s[1]) s++;
+		lo = hi = *s++;
+		if (*s == '-' && s[1] && s[1] != ']') {
+			s++;
+			if (*s == '\\' && s[1]) s++;
+			hi = *s++;
+		}
+		for (; lo <= hi; lo++) set[lo >> 3] |= 1 << (lo & 7);
+	}
+	if (*s != ']') return -1;
+	if (negate)
+		for (i = 0; i < 32; i++) set[i] = ~set[i];
+	set[0] &= ~1;           /* never match the terminating NUL */
+	*ps = (const char *)s + 1;
+	return p->nclasses++;
+}
+
+/* Parse a concatenation up to '|', ')' or the end; return its first node,
+ * -1 if it is empty, or -2 on error.
+ */
+static int parse_seq(strpat *p, const char **ps)
+{
+	const char *s = *ps;
+	int head = -1, tail = -1, n;
+
+	while (*s && *s != '|' && *s != ')') {
+		switch (*s) {
+		case '(':
+			++s;
+			if ((n = parse_alt(p, &s)) < 0 || *s++ != ')') return -2;
+			break;
+		case '.':
+			++s;
+			if ((n = new_node(p, ANY)) < 0) return -2;
+			break;
+		case '[':
+			++s;
+			if ((n = new_node(p, CLASS)) < 0) return -2;
+			if ((p->node[n].c = parse_class(p, &s)) == (unsigned char)-1)
+				return -2;
+			break;
+		case '*':
+			return -2;
+		case '\\':
+			if (!*++s) return -2;
+			/* fall through */
+		default:
+			if ((n = new_node(p, CHAR)) < 0) return -2;
+			p->node[n].c = *s++;
+			break;
+		}
+		if (*s == '*') {
+			if (p->node[n].type == GROUP) return -2;
+			p->node[n].star = 1;
+			++s;
+		}
+		if (tail < 0) head = n;
+		else p->node[tail].next = n;
+		tail = n;
+	}
+	*ps = s;
+	return head;
+}
+
+/* Parse alternatives separated by '|'; return the GROUP node or -1. */
+static int parse_alt(strpat *p, const char **ps)
+{
+	int g, b, prev = -1, seq;
+
+	if ((g = new_node(p, GROUP)) < 0) return -1;
+	for (;;) {
+		if ((b = new_node(p, BRANCH)) < 0) return -1;
+		if ((seq = parse_seq(p, ps)) == -2) return -1;
+		p->node[b].sub = seq;
+		if (prev < 0) p->node[g].sub = b;
+		else p->node[prev].alt = b;
+		prev = b;
+		if (**ps != '|') return g;
+		++*ps;
+	}
+}
+
+static int shortest(const struct lits *x)
+{
+	int i, m = 0;
+
+	for (i = 0; i < x->n; i++)
+		if (!i || x->l[i].len < m) m = x->l[i].len;
+	return m;
+}
+
+/* Is literal set a a better prefilter than b?  Longer literals are rarer;
+ * fewer of them mean fewer strstr calls.
+ */
+static int better(const struct lits *a, const struct lits *b)
+{
+	if (!a->n) return 0;
+	if (!b->n) return 1;
+	if (shortest(a) != shortest(b)) return shortest(a) > shortest(b);
+	return a->n < b->n;
+}
+
+static void alt_lits(const strpat *p, int g, struct lits *out);
+
+/* Find the best literal set required by the sequence starting at node n. */
+static void seq_lits(const strpat *p, int n, struct lits *best)
+{
+	const struct strpat_node *nd;
+	struct lits cand;
+	int run = -1, len = 0;
+
+	best->n = 0;
+	for (;; n = nd->next) {
+		nd = n >= 0 ? &p->node[n] : NULL;
+		if (nd && nd->type == CHAR && !nd->star) {
+			if (len < STRPAT_MAXLIT && !len++) run = n;
+			continue;
+		}
+		if (len) {
+			cand.n = 1;
+			cand.l[0].node = run;
+			cand.l[0].len = len;
+			if (better(&cand, best)) *best = cand;
+			len = 0;
+		}
+		if (!nd) break;
+		if (nd->type == GROUP) {
+			alt_lits(p, n, &cand);
+			if (better(&cand, best)) *best = cand;
+		}
+	}
+}
+
+/* A group requires one of the literals required by each of its branches. */
+static void alt_lits(const strpat *p, int g, struct lits *out)
+{
+	struct lits b;
+	int br, i;
+
+	out->n = 0;
+	for (br = p->node[g].sub; br >= 0; br = p->node[br].alt) {
+		seq_lits(p, p->node[br].sub, &b);
+		if (!b.n || out->n + b.n > STRPAT_MAXLITS) {
+			out->n = 0;
+			return;
+		}
+		for (i = 0; i < b.n; i++) out->l[out->n++] = b.l[i];
+	}
+}
+
+/* strpat_compile compiles pattern into *p.  It returns 0, or -1 if the
+ * pattern is malformed or too big for a strpat.
+ */
+int strpat_compile(strpat *p, const char *pattern)
+{
+	struct lits lits;
+	int i, j, n, off = 0;
+
+	p->nnodes = p->nclasses = p->nlits = 0;
+	if (parse_alt(p, &pattern) != 0 || *pattern) return -1;
+
+	alt_lits(p, 0, &lits);
+	for (i = 0; i < lits.n; i++) {
+		p->lit[i] = off;
+		for (j = 0, n = lits.l[i].node; j < lits.l[i].len; j++) {
+			p->litbuf[off++] = p->node[n].c;
+			n = p->node[n].next;
+		}
+		p->litbuf[off++] = '\0';
+	}
+	p->nlits = lits.n;
+	return 0;
+}
+
+static int one(const strpat *p, const struct strpat_node *nd, unsigned char c)
+{
+	switch (nd->type) {
+	case CHAR:  return c == nd->c && c;
+	case ANY:   return c != '\0';
+	default:    return p->cls[nd->c][c >> 3] >> (c & 7) & 1;
+	}
+}
+
+/* Match the sequence from node n, then the continuation k, against s.
+ * Return the end of the match or NULL.
+ */
+static const char *match(const strpat *p, int n, const char *s,
+                         const struct cont *k)
+{
+	const struct strpat_node *nd;
+	const char *e, *t;
+	struct cont up;
+	int b;
+
+	for (; n >= 0; n = nd->next) {
+		nd = &p->node[n];
+		if (nd->type == GROUP) {
+			up.node = nd->next;
+			up.up = k;
+			for (b = nd->sub; b >= 0; b = p->node[b].alt)
+				if ((e = match(p, p->node[b].sub, s, &up))) return e;
+			return NULL;
+		}
+		if (nd->star) {
+			for (t = s; one(p, nd, *t); t++) ;
+			for (;; t--) {
+				if ((e = match(p, nd->next, t, k))) return e;
+				if (t == s) return NULL;
+			}
+		}
+		if (!one(p, nd, *s)) return NULL;
+		s++;
+	}
+	return k ? match(p, k->node, s, k->up) : s;
+}
+
+/* strpat_search returns a pointer to the start of the leftmost match of
+ * compiled pattern p in string s, or a NULL pointer if there is none.
+ * If end is not NULL and there is a match, *end is set to point just past
+ * the match.
+ */
+const char *strpat_search(const strpat *p, const char *s, const char **end)
+{
+	const char *e;
+	int i;
+
+	for (i = 0; i < p->nlits; i++)
+		if (strstr(s, p->litbuf + p->lit[i])) break;
+	if (p->nlits && i == p->nlits) return NULL;
+
+	for (;; s++) {
+		if ((e = match(p, 0, s, NULL))) {
+			if (end) *end = e;
+			return s;
+		}
+		if (!*s) return NULL;
+	}
+}
@@ -0,0 +1,112 @@
+/* Date: 2026-10-19
+ * This file is public domain per CC0 1.0, see
+ * https://creativecommons.org/publicdomain/mark/1.0/
+ *
+ * Prepared needles for searching many haystacks for the same string.
+ *
+ * Like strstr.c, nothing here calls malloc and nothing keeps state between
+ * calls, so every function may be used from embedded code, from signal
+ * handlers and from several threads at once.  The tables a prepared needle
+ * needs live in memory the caller supplies: either one needle at a time
+ * with strstr_prepare, or many packed one after another into a
+ * strstr_arena, so thousands of needles occupy one contiguous block.
+ * strstr_prepare_size reports the memory a needle needs before any is
+ * committed; the sizes of several needles add up to the arena they need.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "strstr.h"
+
+#define ALIGN(n)	(((n) + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1))
+
+/* bytes of haystack checked for a NUL at a time */
+#define CHUNK	256
+
+/* strstr_prepare_size returns the bytes of memory, a multiple of
+ * sizeof(size_t), that strstr_prepare needs for needle.
+ */
+size_t strstr_prepare_size(const char *needle)
+{
+	return ALIGN(offsetof(strstr_needle, text) + strlen(needle) + 1);
+}
+
+/* strstr_prepare builds a prepared needle for needle in the size bytes at
+ * mem, which must be aligned like a size_t.  It returns mem, or a NULL
+ * pointer if mem is misaligned or smaller than strstr_prepare_size(needle).
+ */
+strstr_needle *strstr_prepare(void *mem, size_t size, const char *needle)
+{
+	strstr_needle *n = (strstr_needle *)mem;
+	size_t len = strlen(needle), i;
+
+	if ((uintptr_t)mem % sizeof(size_t)
+			|| size < offsetof(strstr_needle, text) + len + 1)
+		return NULL;
+
+	// Horspool shifts, capped to fit in a byte
+	n->len = len;
+	memset(n->skip, len < 255 ? (int)len : 255, sizeof n->skip);
+	for (i = 0; i + 1 < len; i++)
+		n->skip[(unsigned char)needle[i]] =
+			len - 1 - i < 255 ? (unsigned char)(len - 1 - i) : 255;
+	memcpy(n->text, needle, len + 1);
+	return n;
+}
+
+/* strstr_arena_init makes the size bytes at mem an empty arena. */
+void strstr_arena_init(strstr_arena *a, void *mem, size_t size)
+{
+	size_t pad = ALIGN((uintptr_t)mem) - (uintptr_t)mem;
+
+	a->base = (char *)mem + (pad < size ? pad : size);
+	a->size = pad < size ? size - pad : 0;
+	a->used = 0;
+}
+
+/* strstr_arena_prepare prepares needle in the next free part of arena a.
+ * It returns the prepared needle, or a NULL pointer if a is full.
+ */
+strstr_needle *strstr_arena_prepare(strstr_arena *a, const char *needle)
+{
+	size_t need = strstr_prepare_size(needle);
+	strstr_needle *n;
+
+	if (need > a->size - a->used) return NULL;
+	n = strstr_prepare(a->base + a->used, need, needle);
+	a->used += need;
+	return n;
+}
+
+/* strstr_prepared returns a pointer to the first occurrence of prepared
+ * needle n in string s1, or a NULL pointer if it does not occur in s1.  It
+ * returns s1 if the needle is a zero length string.
+ *
+ * Algorithm: Boyer-Moore-Horspool.  The haystack's length is not known in
+ * advance, so it is checked for a NUL (with strnlen) just far enough ahead
+ * of the window, CHUNK bytes at a time.
+ */
+char *strstr_prepared(const char *s1, const strstr_needle *n)
+{
+	const unsigned char *s = (const unsigned char *)s1, *known = s;
+	const size_t m = n->len;
+	unsigned char last, c;
+	size_t k;
+
+	if (!m) return (char *)s1;
+	if (m == 1) return strchr(s1, n->text[0]);   // no shift to gain
+	last = n->text[m - 1];
+
+	for (;;) {
+		// make sure s[0..m) holds no NUL
+		if ((size_t)(known - s) < m) {
+			k = strnlen((const char *)known, s + m - known + CHUNK);
+			if ((size_t)(known + k - s) < m) return NULL;
+			known += k;
+		}
+		if ((c = s[m - 1]) == last && !memcmp(s, n->text, m - 1))
+			return (char *)s;
+		s += n->skip[c];
+	}
+}
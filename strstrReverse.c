@@ -0,0 +1,136 @@
+/* Date: 2026-10-19
+ * This file is public domain per CC0 1.0, see
+ * https://creativecommons.org/publicdomain/mark/1.0/
+ *
+ * Last-occurrence search.  strrstr and memrmem scan backward from the end
+ * of the haystack and stop at the first match they meet, instead of
+ * calling strstr in a loop that scans the whole haystack:
+ *
+ *     for (last = NULL; (p = strstr(s1, s2)) != NULL; s1 = p + 1) {
+ *         last = p;
+ *         if (!*p) break;
+ *     }
+ *
+ * They return what that loop leaves in last, including for overlapping
+ * occurrences ("aa" is last found in "aaa" at offset 1).  For a zero
+ * length s2 that is the end of the haystack, where the loop stops: the
+ * last place a zero length string occurs.
+ */
+
+#include <string.h>
+#include "strstr.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* memrmem_scalar returns a pointer to the last occurrence of the nl bytes
+ * at n in the hl bytes at h, or a NULL pointer if there is none.  It
+ * returns h + hl if nl is zero.
+ *
+ * Algorithm: strstr.c's, backward: a memrchr-like search for n's first
+ * byte, then a comparison of the rest of n.
+ */
+void *memrmem_scalar(const void *h, size_t hl, const void *n, size_t nl)
+{
+	register const char *s = (const char *)h, *p;
+	register const char *s2 = (const char *)n;
+	register char c;
+
+	if (!nl) return (char *)h + hl;
+	if (nl > hl) return NULL;
+
+	c = *s2++;
+	for (p = s + (hl - nl);; --p) {
+		// memrchr-like for loop unrolled for speed
+		for (; *p != c; --p) {
+			if (p == s) return NULL;
+			if (*--p == c) break;
+			if (p == s) return NULL;
+		}
+		if (!memcmp(p + 1, s2, nl - 1)) return (char *)p;
+		if (p == s) return NULL;
+	}
+}
+
+/* memrmem_horspool is memrmem by Boyer-Moore-Horspool run right to left.
+ * The shift is taken from the window's first byte: the distance to the
+ * nearest occurrence of that byte in n[1..nl-1], else nl.
+ */
+void *memrmem_horspool(const void *h, size_t hl, const void *n, size_t nl)
+{
+	const unsigned char *s = (const unsigned char *)h, *p;
+	const unsigned char *s2 = (const unsigned char *)n;
+	size_t shift[256], i;
+
+	if (!nl) return (char *)h + hl;
+	if (nl > hl) return NULL;
+
+	for (i = 0; i < 256; i++) shift[i] = nl;
+	for (i = nl - 1; i > 0; i--) shift[s2[i]] = i;
+
+	for (p = s + (hl - nl);; p -= shift[*p]) {
+		if (*p == *s2 && !memcmp(p + 1, s2 + 1, nl - 1)) return (void *)p;
+		if ((size_t)(p - s) < shift[*p]) return NULL;
+	}
+}
+
+#ifdef __SSE2__
+/* memrmem_sse2 is memrmem comparing 16 candidate positions at a time
+ * against both the first and the last byte of n, from the end of h back.
+ * Only candidates that pass both tests are compared in full.
+ */
+void *memrmem_sse2(const void *h, size_t hl, const void *n, size_t nl)
+{
+	const char *s = (const char *)h, *s2 = (const char *)n;
+	__m128i first, last;
+	unsigned mask;
+	size_t i;
+	int b;
+
+	if (!nl) return (char *)h + hl;
+	if (nl > hl) return NULL;
+
+	first = _mm_set1_epi8(s2[0]);
+	last = _mm_set1_epi8(s2[nl - 1]);
+	// candidates [i, i + 16) are tested; i + 15 + nl - 1 < hl
+	for (i = hl - nl + 1; i >= 16;) {
+		i -= 16;
+		mask = _mm_movemask_epi8(_mm_and_si128(
+			_mm_cmpeq_epi8(first, _mm_loadu_si128((const __m128i *)(s + i))),
+			_mm_cmpeq_epi8(last,
+				_mm_loadu_si128((const __m128i *)(s + i + nl - 1)))));
+		while (mask) {
+			b = 31 - __builtin_clz(mask);
+			if (nl <= 2 || !memcmp(s + i + b + 1, s2 + 1, nl - 2))
+				return (char *)s + i + b;
+			mask &= ~(1u << b);
+		}
+	}
+	// fewer than 16 candidates remain, at [0, i)
+	return i ? memrmem_scalar(h, i + nl - 1, n, nl) : NULL;
+}
+#endif
+
+/* memrmem returns a pointer to the last occurrence of the nl bytes at n
+ * in the hl bytes at h, or a NULL pointer if there is none.  It returns
+ * h + hl if nl is zero.
+ */
+void *memrmem(const void *h, size_t hl, const void *n, size_t nl)
+{
+#ifdef __SSE2__
+	return memrmem_sse2(h, hl, n, nl);
+#else
+	if (nl >= 16) return memrmem_horspool(h, hl, n, nl);
+	return memrmem_scalar(h, hl, n, nl);
+#endif
+}
+
+/* strrstr returns a pointer to the last occurrence of string s2 in string
+ * s1, or a NULL pointer if s2 does not occur in s1.  It returns a pointer
+ * to s1's terminating NUL if s2 points to a zero length string.
+ */
+char *strrstr(const char *s1, const char *s2)
+{
+	return (char *)memrmem(s1, strlen(s1), s2, strlen(s2));
+}
@@ -0,0 +1,463 @@
+/* Date: 2026-10-19
+ * This file is public domain per CC0 1.0, see
+ * https://creativecommons.org/publicdomain/mark/1.0/
+ *
+ * Vector strstr kernels.  strstr_simd is whichever of them suits the
+ * machine the file is compiled for:
+ *
+ *   x86-64 (or any SSE2 target)   strstr_sse2
+ *   AArch64 compiled with SVE     strstr_sve
+ *   AArch64                       strstr_neon
+ *   anything else                 strstr_short's kernels up to 8 bytes,
+ *                                 else strstr
+ *
+ * except that a one-byte needle is always searched for with strchr.
+ *
+ * strstr_sse2 and strstr_neon test 16 candidate positions at a time
+ * against both the first and the last byte of s2 and compare only the
+ * survivors in full.  Their loads read ahead of the candidates, so the
+ * haystack is checked for its NUL first (with strnlen) one window at a
+ * time and only the part known to precede the NUL is searched.
+ *
+ * strstr_sve needs no such window.  Its first-faulting loads stop short of
+ * an unmapped page instead of faulting, so it scans the NUL-terminated
+ * haystack directly, a vector of bytes at a time, for s2's first byte.
+ *
+ * AArch64 builds can be tested on x86 Linux under qemu-user, one with SVE
+ * and one without (see README.md):
+ *   aarch64-linux-gnu-gcc -O2 -march=armv8.2-a+sve -static ...
+ *   qemu-aarch64 -cpu max,sve512=on ./a.out
+ *   aarch64-linux-gnu-gcc -O2 -march=armv8-a -static ...
+ *   qemu-aarch64 -cpu max,sve=off ./a.out
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "strstr.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#ifdef __ARM_FEATURE_SVE
+#include <arm_sve.h>
+#endif
+#endif
+
+/* haystack bytes checked for a NUL and then searched at a time */
+#define WINDOW	4096
+
+typedef const char *(*find_fn)(const char *, size_t, const char *, size_t);
+
+/* Run find over s1 one window at a time.  Consecutive windows overlap by
+ * strlen(s2) - 1 bytes, so a match straddling two of them is not missed.
+ */
+static char *windowed(const char *s1, const char *s2, find_fn find)
+{
+	size_t m = strlen(s2), w, n;
+	const char *r;
+
+	if (!m) return (char *)s1;
+	w = WINDOW + m;
+	for (;;) {
+		if ((n = strnlen(s1, w)) < m) return NULL;
+		if ((r = find(s1, n, s2, m)) != NULL) return (char *)r;
+		if (n < w) return NULL;
+		s1 += n - m + 1;
+	}
+}
+
+#if defined(__SSE2__) || defined(__aarch64__)
+typedef size_t (*count_fn)(const char *, size_t, const char *, size_t);
+
+/* Find the first of needle nd (m >= 1 bytes) in the n bytes at h, trying
+ * candidate positions from i on, one at a time.
+ */
+static const char *find_scalar(const char *h, size_t n, const char *nd,
+                               size_t m, size_t i)
+{
+	for (; i + m <= n; i++)
+		if (h[i] == nd[0] && !memcmp(h + i + 1, nd + 1, m - 1))
+			return h + i;
+	return NULL;
+}
+
+/* Count the occurrences of nd in the n bytes at h that start at i or later,
+ * one candidate position at a time.
+ */
+static size_t count_scalar(const char *h, size_t n, const char *nd,
+                           size_t m, size_t i)
+{
+	size_t k = 0;
+
+	for (; i + m <= n; i++)
+		if (h[i] == nd[0] && !memcmp(h + i + 1, nd + 1, m - 1)) k++;
+	return k;
+}
+
+/* Run count over s1 one window at a time.  A window counts only the
+ * occurrences that start before the next window does.
+ */
+static size_t windowed_count(const char *s1, const char *s2, count_fn count)
+{
+	size_t m = strlen(s2), w, n, k = 0;
+
+	if (!m) return strlen(s1) + 1;
+	w = WINDOW + m;
+	for (;;) {
+		if ((n = strnlen(s1, w)) < m) return k;
+		k += count(s1, n, s2, m);
+		if (n < w) return k;
+		s1 += n - m + 1;
+	}
+}
+#endif
+
+#ifdef __SSE2__
+static unsigned popcount16(unsigned x)
+{
+	x -= x >> 1 & 0x5555;
+	x = (x & 0x3333) + (x >> 2 & 0x3333);
+	x = (x + (x >> 4)) & 0x0f0f;
+	return (x + (x >> 8)) & 0x1f;
+}
+
+static const char *find_sse2(const char *h, size_t n, const char *nd,
+                             size_t m)
+{
+	const __m128i first = _mm_set1_epi8(nd[0]);
+	const __m128i last = _mm_set1_epi8(nd[m - 1]);
+	unsigned mask;
+	size_t i;
+	int b;
+
+	// candidates [i, i + 16) are tested; i + 15 + m - 1 < n
+	for (i = 0; i + 16 + m - 1 <= n; i += 16) {
+		mask = _mm_movemask_epi8(_mm_and_si128(
+			_mm_cmpeq_epi8(first, _mm_loadu_si128((const __m128i *)(h + i))),
+			_mm_cmpeq_epi8(last,
+				_mm_loadu_si128((const __m128i *)(h + i + m - 1)))));
+		while (mask) {
+			b = __builtin_ctz(mask);
+			if (m <= 2 || !memcmp(h + i + b + 1, nd + 1, m - 2))
+				return h + i + b;
+			mask &= mask - 1;
+		}
+	}
+	return find_scalar(h, n, nd, m, i);
+}
+
+/* Counting drops candidates that fail the full comparison from the mask
+ * and adds up what is left, so no match position is ever computed.  A
+ * needle of one or two bytes needs no comparison, so its masks are added
+ * up in a vector of byte counters, folded into sum with psadbw before any
+ * counter can overflow.
+ */
+static size_t count_sse2(const char *h, size_t n, const char *nd, size_t m)
+{
+	const __m128i first = _mm_set1_epi8(nd[0]);
+	const __m128i last = _mm_set1_epi8(nd[m - 1]);
+	const __m128i zero = _mm_setzero_si128();
+	__m128i eq, acc = zero, sum = zero;
+	unsigned mask, rest, blocks = 0;
+	size_t i, k = 0;
+	int b;
+
+	for (i = 0; i + 16 + m - 1 <= n; i += 16) {
+		eq = _mm_and_si128(
+			_mm_cmpeq_epi8(first, _mm_loadu_si128((const __m128i *)(h + i))),
+			_mm_cmpeq_epi8(last,
+				_mm_loadu_si128((const __m128i *)(h + i + m - 1))));
+		if (m <= 2) {
+			acc = _mm_sub_epi8(acc, eq);
+			if (++blocks == 255) {
+				sum = _mm_add_epi64(sum, _mm_sad_epu8(acc, zero));
+				acc = zero;
+				blocks = 0;
+			}
+			continue;
+		}
+		if (!(mask = _mm_movemask_epi8(eq))) continue;
+		for (rest = mask; rest; rest &= rest - 1) {
+			b = __builtin_ctz(rest);
+			if (memcmp(h + i + b + 1, nd + 1, m - 2)) mask &= ~(1u << b);
+		}
+		k += popcount16(mask);
+	}
+	sum = _mm_add_epi64(sum, _mm_sad_epu8(acc, zero));
+	k += _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+	return k + count_scalar(h, n, nd, m, i);
+}
+
+/* strstr_sse2 returns a pointer to the first occurrence of string s2 in
+ * string s1, or a NULL pointer if s2 does not occur in s1.  It returns s1
+ * if s2 points to a zero length string.
+ */
+char *strstr_sse2(const char *s1, const char *s2)
+{
+	return windowed(s1, s2, find_sse2);
+}
+#endif
+
+#ifdef __aarch64__
+/* NEON has no movemask.  vshrn narrows each 0x00/0xff comparison byte to
+ * a nibble, giving a 64-bit mask with 4 bits per candidate position.
+ */
+static const char *find_neon(const char *h, size_t n, const char *nd,
+                             size_t m)
+{
+	const uint8x16_t first = vdupq_n_u8((uint8_t)nd[0]);
+	const uint8x16_t last = vdupq_n_u8((uint8_t)nd[m - 1]);
+	const uint8_t *u = (const uint8_t *)h;
+	uint8x16_t eq;
+	uint64_t mask;
+	size_t i;
+	int b;
+
+	for (i = 0; i + 16 + m - 1 <= n; i += 16) {
+		eq = vceqq_u8(first, vld1q_u8(u + i));
+		if (m > 1) eq = vandq_u8(eq, vceqq_u8(last, vld1q_u8(u + i + m - 1)));
+		mask = vget_lane_u64(vreinterpret_u64_u8(
+			vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+		while (mask) {
+			b = __builtin_ctzll(mask) >> 2;
+			if (m <= 2 || !memcmp(h + i + b + 1, nd + 1, m - 2))
+				return h + i + b;
+			mask &= ~((uint64_t)0xf << (b * 4));
+		}
+	}
+	return find_scalar(h, n, nd, m, i);
+}
+
+/* strstr_neon is strstr with NEON first+last byte filtering; for a one
+ * byte needle the filter is the first byte alone.
+ */
+char *strstr_neon(const char *s1, const char *s2)
+{
+	return windowed(s1, s2, find_neon);
+}
+
+static size_t count_neon(const char *h, size_t n, const char *nd, size_t m)
+{
+	const uint8x16_t first = vdupq_n_u8((uint8_t)nd[0]);
+	const uint8x16_t last = vdupq_n_u8((uint8_t)nd[m - 1]);
+	const uint8_t *u = (const uint8_t *)h;
+	uint8x16_t eq;
+	uint64_t mask, rest;
+	size_t i, k = 0;
+	int b;
+
+	for (i = 0; i + 16 + m - 1 <= n; i += 16) {
+		eq = vceqq_u8(first, vld1q_u8(u + i));
+		if (m > 1) eq = vandq_u8(eq, vceqq_u8(last, vld1q_u8(u + i + m - 1)));
+		mask = vget_lane_u64(vreinterpret_u64_u8(
+			vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+		if (m > 2)
+			for (rest = mask; rest; rest &= ~((uint64_t)0xf << (b * 4))) {
+				b = __builtin_ctzll(rest) >> 2;
+				if (memcmp(h + i + b + 1, nd + 1, m - 2))
+					mask &= ~((uint64_t)0xf << (b * 4));
+			}
+		k += __builtin_popcountll(mask) >> 2;
+	}
+	return k + count_scalar(h, n, nd, m, i);
+}
+
+#ifdef __ARM_FEATURE_SVE
+/* strstr_sve is strstr scanning for s2's first byte with SVE first-faulting
+ * loads, which load as many bytes as are readable (at least one) and
+ * record in the FFR which those were.  Candidates are verified one at a
+ * time, char by char like strstr.c, so nothing past the NUL is read.
+ */
+char *strstr_sve(const char *s1, const char *s2)
+{
+	const uint8_t *s = (const uint8_t *)s1;
+	const svbool_t all = svptrue_b8();
+	const char *p1, *p2;
+	svbool_t ok, live, cand, lane;
+	svuint8_t v;
+	uint8_t c;
+	uint64_t i;
+
+	if (!(c = (uint8_t)*s2++)) return (char *)s1;
+
+	for (;;) {
+		svsetffr();
+		v = svldff1_u8(all, s);
+		ok = svrdffr();
+		// lanes before the first NUL, then those holding c
+		live = svbrkb_b_z(ok, svcmpeq_n_u8(ok, v, 0));
+		cand = svcmpeq_n_u8(live, v, c);
+		for (lane = svpfalse_b();
+				svptest_any(all, lane = svpnext_b8(cand, lane));) {
+			i = svcntp_b8(all, svbrkb_b_z(all, lane));
+			for (p1 = (const char *)s + i + 1, p2 = s2;
+					(*p1 == *p2) && *p2;) ++p1, ++p2;
+			if (!*p2) return (char *)s + i;
+		}
+		if (svcntp_b8(all, live) != svcntp_b8(all, ok)) return NULL;
+		s += svcntp_b8(all, ok);
+	}
+}
+#endif
+#endif
+
+static uint16_t load16(const void *p)
+{
+	uint16_t v;
+
+	memcpy(&v, p, sizeof v);
+	return v;
+}
+
+static uint32_t load32(const void *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof v);
+	return v;
+}
+
+static uint64_t load64(const void *p)
+{
+	uint64_t v;
+
+	memcpy(&v, p, sizeof v);
+	return v;
+}
+
+/* Find nd, 3 to 8 bytes long, in the n >= m bytes at h: memchr for its
+ * first byte, then one 32 or 64-bit load and compare for the whole needle.
+ * A candidate too near the end of the n bytes for the load is compared
+ * with memcmp instead.
+ */
+static const char *find_wide(const char *h, size_t n, const char *nd,
+                             size_t m)
+{
+	static const unsigned char ones[16] = {
+		0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+	};
+	const size_t w = m <= 4 ? 4 : 8;
+	const char *p = h, *end = h + n;
+	uint64_t want = 0, mask = 0;
+	uint32_t want32 = 0, mask32 = 0;
+
+	if (w == 4) {
+		memcpy(&mask32, ones + 8 - m, 4);
+		memcpy(&want32, nd, m);
+	} else {
+		memcpy(&mask, ones + 8 - m, 8);
+		memcpy(&want, nd, m);
+	}
+	for (; (p = memchr(p, nd[0], end - m + 1 - p)) != NULL; p++) {
+		if ((size_t)(end - p) < w) {
+			if (!memcmp(p, nd, m)) return p;
+		} else if (w == 4 ? (load32(p) & mask32) == want32
+		                  : (load64(p) & mask) == want)
+			return p;
+	}
+	return NULL;
+}
+
+/* Find s2, m <= 8 bytes long, in s1: strchr for its first byte, then one
+ * 16-bit load and compare for a two-byte needle, which cannot pass the
+ * NUL since the first byte is not one.  Longer needles are searched for
+ * with find_wide one window at a time, the way the vector kernels are, so
+ * its loads stay within the part of s1 known to precede the NUL.
+ */
+static char *find_short(const char *s1, const char *s2, size_t m)
+{
+	uint16_t want16;
+	const char c = s2[0];
+
+	switch (m) {
+	case 0:
+		return (char *)s1;
+	case 1:
+		return strchr(s1, c);
+	case 2:
+		want16 = load16(s2);
+		for (; (s1 = strchr(s1, c)) != NULL; s1++)
+			if (load16(s1) == want16) return (char *)s1;
+		return NULL;
+	default:
+		return windowed(s1, s2, find_wide);
+	}
+}
+
+/* strstr_short is strstr for needles of up to 8 bytes, specialized by
+ * length; longer needles are passed to strstr_simd.
+ */
+char *strstr_short(const char *s1, const char *s2)
+{
+	size_t m;
+
+	for (m = 0; m < 9 && s2[m]; m++) ;
+	return m <= 8 ? find_short(s1, s2, m) : strstr_simd(s1, s2);
+}
+
+/* strstr_simd returns a pointer to the first occurrence of string s2 in
+ * string s1, or a NULL pointer if s2 does not occur in s1.  It returns s1
+ * if s2 points to a zero length string.
+ *
+ * One-byte needles go to the C library's strchr, itself vectorized.
+ * Where there is no vector kernel, needles of up to 8 bytes go to
+ * find_short; where there is one, it is faster for those too.
+ */
+char *strstr_simd(const char *s1, const char *s2)
+{
+#if !defined(__SSE2__) && !defined(__aarch64__)
+	size_t m;
+#endif
+
+	if (!s2[0]) return (char *)s1;
+	if (!s2[1]) return strchr(s1, s2[0]);
+#if defined(__SSE2__)
+	return strstr_sse2(s1, s2);
+#elif defined(__ARM_FEATURE_SVE)
+	return strstr_sve(s1, s2);
+#elif defined(__aarch64__)
+	return strstr_neon(s1, s2);
+#else
+	for (m = 2; m < 9 && s2[m]; m++) ;
+	return m <= 8 ? find_short(s1, s2, m) : strstr(s1, s2);
+#endif
+}
+
+/* strstr_count returns the number of occurrences of string s2 in string
+ * s1, overlapping ones included: as many as the loop
+ *
+ *     for (k = 0; (p = strstr(s1, s2)) != NULL; s1 = p + 1) {
+ *         k++;
+ *         if (!*p) break;
+ *     }
+ *
+ * counts.  A zero length s2 occurs strlen(s1) + 1 times.
+ */
+size_t strstr_count(const char *s1, const char *s2)
+{
+#if defined(__SSE2__)
+	return windowed_count(s1, s2, count_sse2);
+#elif defined(__aarch64__)
+	return windowed_count(s1, s2, count_neon);
+#else
+	size_t k = 0;
+
+	for (; (s1 = strstr(s1, s2)) != NULL; s1++) {
+		k++;
+		if (!*s1) break;
+	}
+	return k;
+#endif
+}
+
+/* strcontains returns nonzero if string s2 occurs in string s1.  It
+ * answers the question "if (strstr(s1, s2))" asks, for call sites that
+ * do not use the match position.
+ */
+int strcontains(const char *s1, const char *s2)
+{
+	if (!s2[0]) return 1;
+	if (!s2[1]) return strchr(s1, s2[0]) != NULL;
+	return strstr_simd(s1, s2) != NULL;
+}
@@ -0,0 +1,106 @@
+/* Date: 2026-10-19
+ * This file is public domain per CC0 1.0, see
+ * https://creativecommons.org/publicdomain/mark/1.0/
+ *
+ * strstr_stream is strstr.c's algorithm for haystacks too big for the last
+ * level cache.  It issues one software prefetch per 64-byte cache line,
+ * a given distance ahead of the scan, so the search does not stall on DRAM
+ * when the hardware prefetcher loses track (e.g. when many haystacks are
+ * scanned interleaved).  Non-temporal prefetches may be asked for, so a
+ * scanned haystack does not evict the caller's working set from the outer
+ * caches.  strstr_stream uses STRSTR_PREFETCH_DISTANCE and the ordinary
+ * hint; strstr_stream_ex takes both as arguments.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "strstr.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(p)		__builtin_prefetch((const void *)(p), 0, 3)
+#define PREFETCH_NTA(p)	__builtin_prefetch((const void *)(p), 0, 0)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define PREFETCH(p)		_mm_prefetch((const char *)(p), _MM_HINT_T0)
+#define PREFETCH_NTA(p)	_mm_prefetch((const char *)(p), _MM_HINT_NTA)
+#else
+#define PREFETCH(p)		((void)0)
+#define PREFETCH_NTA(p)	((void)0)
+#endif
+
+#define LINE	64
+
+/* lines prefetched before the scan starts; the rest of the distance is
+ * covered as it goes, so short haystacks cost few prefetches
+ */
+#define RAMP	4
+
+/* Prefetching past the end of the haystack is harmless: prefetches never
+ * fault.  Addresses are formed with uintptr_t for that reason.
+ */
+static void prefetch(uintptr_t p, int nta)
+{
+	if (nta) PREFETCH_NTA(p);
+	else PREFETCH(p);
+}
+
+/* strstr_stream_ex returns a pointer to the first occurrence of string s2
+ * in string s1, or a NULL pointer if s2 does not occur in s1.  It returns
+ * s1 if s2 points to a zero length string.  It prefetches dist bytes ahead
+ * of the scan, non-temporally if nta is nonzero.
+ *
+ * Algorithm: strstr.c's, with the strchr-like scan split at cache line
+ * boundaries.  Crossing into a new line prefetches the line dist bytes
+ * further on, and until that distance is first reached one more.
+ */
+char *strstr_stream_ex(register const char *s1, register const char *s2,
+                       size_t dist, int nta)
+{
+	register const char *p1, *p2;
+	register char c;
+	uintptr_t line, ahead;
+	int k;
+
+	if (!(c = *s2++)) return (char *)s1;
+
+	// line is the start of the next cache line, ahead the next to prefetch
+	line = ((uintptr_t)s1 | (LINE - 1)) + 1;
+	for (ahead = line, k = 0; k < RAMP && ahead < line + dist;
+			k++, ahead += LINE)
+		prefetch(ahead, nta);
+
+	for (;;) {
+		// strchr-like loop unrolled for speed; the cache line check is
+		// made before every four characters and after every candidate,
+		// so it lags the scan by at most three characters
+		for (;;) {
+			if ((uintptr_t)s1 >= line) {
+				line += LINE;
+				if (ahead < line + dist) {
+					prefetch(ahead, nta);
+					ahead += LINE;
+				}
+				if (ahead < line + dist) {
+					prefetch(ahead, nta);
+					ahead += LINE;
+				}
+			}
+			if (*s1 == c) break;
+			if (!*s1++) return NULL;
+			if (*s1 == c) break;
+			if (!*s1++) return NULL;
+			if (*s1 == c) break;
+			if (!*s1++) return NULL;
+			if (*s1 == c) break;
+			if (!*s1++) return NULL;
+		}
+		for (p1 = ++s1, p2 = s2; (*p1 == *p2) && *p2;) ++p1, ++p2;
+		if (!*p2) return (char *)--s1;
+	}
+}
+
+/* strstr_stream is strstr_stream_ex with the default distance and hint. */
+char *strstr_stream(const char *s1, const char *s2)
+{
+	return strstr_stream_ex(s1, s2, STRSTR_PREFETCH_DISTANCE, 0);
+}
@@ -0,0 +1,451 @@
+/* Date: 2026-10-19
+ * This file is public domain per CC0 1.0, see
+ * https://creativecommons.org/publicdomain/mark/1.0/
+ *
+ * Search many files for a string with Linux io_uring (kernel 5.6 or later).
+ *
+ * strstr_uring_search keeps nbufs reads in flight at once, into a ring of
+ * reusable buffers, and searches each buffer with strstr as soon as its
+ * read completes while the others are still being read, so reading and
+ * searching overlap completely.  A file may have several reads in flight.
+ * Consecutive reads of a file overlap by strlen(needle) - 1 bytes, so an
+ * occurrence spanning two buffers is not missed.  Once an occurrence is
+ * found, no more of the file after it is read.
+ *
+ * Files are opened with open(2) as buffers become free; only the reads go
+ * through the ring.  The ring is set up with the raw system calls, so
+ * liburing is not needed.  Like strstrPrepared.c, nothing is allocated:
+ * the caller supplies strstr_uring_memsize(bufsize, nbufs) bytes.
+ *
+ * Compiled with -DSTRSTR_URING_MAIN this file is also a benchmark that
+ * compares strstr_uring_search with read(2) and strstr on the same files:
+ *
+ *   cc -O2 -DSTRSTR_URING_MAIN -o strstrUring strstrUring.c strstr.c
+ *   strstrUring [-b bufsize] [-n nbufs] needle file...
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "strstr.h"
+
+#define ALIGN(n)	(((n) + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1))
+
+struct ring {
+	int fd;
+	unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+	unsigned *cq_head, *cq_tail, *cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void *sq_ptr, *cq_ptr;
+	size_t sq_len, cq_len, sqes_len;
+	unsigned pending;       /* SQEs queued but not yet submitted */
+};
+
+/* an open file being searched */
+struct file {
+	int fd;                 /* -1 if this slot is free */
+	size_t index;           /* in paths[] */
+	long long size, next;   /* file size, offset of the next read */
+	long long found;        /* offset of the first occurrence, or LLONG_MAX */
+	unsigned inflight;      /* reads in flight */
+	int err;
+};
+
+/* a buffer and the read into it */
+struct buf {
+	struct file *f;         /* NULL if the buffer is free */
+	long long off;          /* file offset of data[0] */
+	size_t len;             /* bytes read into data so far */
+	char *data;             /* bufsize + 1 bytes */
+};
+
+static int ring_init(struct ring *r, unsigned entries)
+{
+	struct io_uring_params p;
+	int fd;
+
+	memset(&p, 0, sizeof p);
+	if ((fd = (int)syscall(__NR_io_uring_setup, entries, &p)) < 0) return errno;
+	r->fd = fd;
+	r->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	r->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		r->sq_len = r->cq_len = r->sq_len > r->cq_len ? r->sq_len : r->cq_len;
+	r->sq_ptr = mmap(NULL, r->sq_len, PROT_READ | PROT_WRITE,
+	                 MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if (r->sq_ptr == MAP_FAILED) goto fail;
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		r->cq_ptr = r->sq_ptr;
+	else {
+		r->cq_ptr = mmap(NULL, r->cq_len, PROT_READ | PROT_WRITE,
+		                 MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		if (r->cq_ptr == MAP_FAILED) goto fail_sq;
+	}
+	r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+	r->sqes = mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE,
+	               MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (r->sqes == MAP_FAILED) goto fail_cq;
+
+	r->sq_head = (unsigned *)((char *)r->sq_ptr + p.sq_off.head);
+	r->sq_tail = (unsigned *)((char *)r->sq_ptr + p.sq_off.tail);
+	r->sq_mask = (unsigned *)((char *)r->sq_ptr + p.sq_off.ring_mask);
+	r->sq_array = (unsigned *)((char *)r->sq_ptr + p.sq_off.array);
+	r->cq_head = (unsigned *)((char *)r->cq_ptr + p.cq_off.head);
+	r->cq_tail = (unsigned *)((char *)r->cq_ptr + p.cq_off.tail);
+	r->cq_mask = (unsigned *)((char *)r->cq_ptr + p.cq_off.ring_mask);
+	r->cqes = (struct io_uring_cqe *)((char *)r->cq_ptr + p.cq_off.cqes);
+	r->pending = 0;
+	return 0;
+
+fail_cq:
+	if (r->cq_ptr != r->sq_ptr) munmap(r->cq_ptr, r->cq_len);
+fail_sq:
+	munmap(r->sq_ptr, r->sq_len);
+fail:
+	fd = errno;
+	close(r->fd);
+	return fd;
+}
+
+static void ring_exit(struct ring *r)
+{
+	munmap(r->sqes, r->sqes_len);
+	if (r->cq_ptr != r->sq_ptr) munmap(r->cq_ptr, r->cq_len);
+	munmap(r->sq_ptr, r->sq_len);
+	close(r->fd);
+}
+
+/* Queue a read of len bytes at off in fd into data, tagged with tag. */
+static void queue_read(struct ring *r, int fd, char *data, unsigned len,
+                       long long off, unsigned tag)
+{
+	unsigned tail = *r->sq_tail, i = tail & *r->sq_mask;
+	struct io_uring_sqe *sqe = &r->sqes[i];
+
+	memset(sqe, 0, sizeof *sqe);
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = fd;
+	sqe->addr = (uintptr_t)data;
+	sqe->len = len;
+	sqe->off = off;
+	sqe->user_data = tag;
+	r->sq_array[i] = i;
+	__atomic_store_n(r->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	r->pending++;
+}
+
+/* Submit the queued reads and wait for at least one to complete. */
+static int ring_enter(struct ring *r)
+{
+	int n;
+
+	do n = (int)syscall(__NR_io_uring_enter, r->fd, r->pending, 1,
+	                    IORING_ENTER_GETEVENTS, NULL, 0);
+	while (n < 0 && errno == EINTR);
+	if (n < 0) return errno;
+	r->pending -= n;
+	return 0;
+}
+
+/* Wait for the n submitted reads still in flight to complete, discarding
+ * their results, so that none of them writes to a buffer after
+ * strstr_uring_search has returned.  Reads queued but never submitted are
+ * left in the ring and dropped with it.
+ */
+static int ring_drain(struct ring *r, unsigned n)
+{
+	unsigned head;
+
+	for (;;) {
+		head = *r->cq_head;
+		for (; n && head != __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE); n--)
+			head++;
+		__atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+		if (!n) return 0;
+		if (syscall(__NR_io_uring_enter, r->fd, 0, 1, IORING_ENTER_GETEVENTS,
+		            NULL, 0) < 0 && errno != EINTR && errno != EAGAIN
+				&& errno != EBUSY)
+			return errno;
+	}
+}
+
+/* Find needle in the len bytes at data, which may hold NULs; return the
+ * offset of the first occurrence or -1.  data[len] is overwritten.
+ */
+static long long search(char *data, size_t len, const char *needle)
+{
+	char *p, *q;
+
+	data[len] = '\0';
+	for (p = data; p < data + len; p += strlen(p) + 1)
+		if ((q = strstr(p, needle)) != NULL) return q - data;
+	return -1;
+}
+
+/* strstr_uring_memsize returns the bytes of memory strstr_uring_search
+ * needs for nbufs buffers of bufsize bytes.
+ */
+size_t strstr_uring_memsize(size_t bufsize, unsigned nbufs)
+{
+	return ALIGN(nbufs * sizeof(struct buf)) + ALIGN(nbufs * sizeof(struct file))
+		+ nbufs * ALIGN(bufsize + 1);
+}
+
+/* strstr_uring_search searches each of the npaths files named in paths for
+ * needle, reading them through io_uring with nbufs reads of bufsize bytes
+ * in flight.  mem is strstr_uring_memsize(bufsize, nbufs) bytes aligned
+ * like a size_t.  As each file is finished, in no particular order,
+ * done(arg, index, offset, err) is called with its index in paths, the
+ * offset of needle's first occurrence in it or -1, and 0 or the errno
+ * value that stopped the search of it.
+ *
+ * It returns 0, EINVAL if bufsize is not at least twice the length of
+ * needle, or the errno value from setting up or entering the ring.  After
+ * a failure to enter the ring it waits for the reads in flight; if it
+ * cannot, it returns EBUSY, and some may still write to mem after it has
+ * returned, so mem must not be freed or reused.
+ */
+int strstr_uring_search(const char *const *paths, size_t npaths,
+                        const char *needle, void *mem, size_t bufsize,
+                        unsigned nbufs, strstr_uring_fn done, void *arg)
+{
+	struct buf *bufs = (struct buf *)mem;
+	struct file *files = (struct file *)((char *)mem
+		+ ALIGN(nbufs * sizeof(struct buf)));
+	char *data = (char *)files + ALIGN(nbufs * sizeof(struct file));
+	size_t m = strlen(needle), nextpath = 0, stride;
+	unsigned i, j, busy = 0, open_files = 0, rr = 0, head;
+	struct io_uring_cqe *cqe;
+	struct ring ring;
+	struct stat st;
+	struct file *f;
+	struct buf *b;
+	long long at;
+	int err, res;
+
+	if (!nbufs || bufsize < 2 * m || bufsize < 2 || bufsize > INT_MAX)
+		return EINVAL;
+	if ((err = ring_init(&ring, nbufs)) != 0) return err;
+	stride = bufsize - (m ? m - 1 : 0);
+	for (i = 0; i < nbufs; i++) {
+		bufs[i].f = NULL;
+		bufs[i].data = data + i * ALIGN(bufsize + 1);
+		files[i].fd = -1;
+	}
+
+	for (;;) {
+		// give every free buffer a read, opening files as needed
+		for (i = 0; i < nbufs; i++) {
+			if (bufs[i].f) continue;
+			for (f = NULL, j = 0; j < nbufs && !f; j++) {
+				f = &files[(rr + j) % nbufs];
+				if (f->fd < 0 || f->err || f->next >= f->size
+						|| f->next > f->found)
+					f = NULL;
+			}
+			rr++;
+			while (!f && nextpath < npaths && open_files < nbufs) {
+				for (f = files; f->fd >= 0; f++) ;
+				f->index = nextpath++;
+				f->next = f->inflight = 0;
+				f->found = LLONG_MAX;
+				if ((f->fd = open(paths[f->index], O_RDONLY)) < 0
+						|| fstat(f->fd, &st) < 0) {
+					done(arg, f->index, -1, errno);
+					if (f->fd >= 0) close(f->fd);
+					f->fd = -1;
+					f = NULL;
+				} else if ((f->size = st.st_size) < (long long)m || !m) {
+					done(arg, f->index, m ? -1 : 0, 0);
+					close(f->fd);
+					f->fd = -1;
+					f = NULL;
+				} else {
+					f->err = 0;
+					open_files++;
+				}
+			}
+			if (!f) break;
+			bufs[i].f = f;
+			bufs[i].off = f->next;
+			bufs[i].len = 0;
+			queue_read(&ring, f->fd, bufs[i].data, bufsize, f->next, i);
+			f->next += stride;
+			f->inflight++;
+			busy++;
+		}
+		if (!busy) break;
+
+		if ((err = ring_enter(&ring)) != 0) break;
+		head = *ring.cq_head;
+		while (head != __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE)) {
+			cqe = &ring.cqes[head++ & *ring.cq_mask];
+			b = &bufs[cqe->user_data];
+			f = b->f;
+			res = cqe->res;
+			__atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+
+			if (res < 0) {
+				f->err = -res;
+			} else if (res > 0 && (b->len += res) < bufsize
+					&& b->off + (long long)b->len < f->size
+					&& b->off < f->found) {
+				// short read: read the rest after what has arrived, so
+				// every retry moves forward
+				queue_read(&ring, f->fd, b->data + b->len,
+				           (unsigned)(bufsize - b->len),
+				           b->off + (long long)b->len, b - bufs);
+				continue;
+			} else if (b->off < f->found
+					&& (at = search(b->data, b->len, needle)) >= 0
+					&& b->off + at < f->found) {
+				f->found = b->off + at;
+			}
+			b->f = NULL;
+			busy--;
+			if (--f->inflight == 0 && (f->err || f->next >= f->size
+					|| f->next > f->found)) {
+				done(arg, f->index, f->found == LLONG_MAX ? -1 : f->found,
+				     f->err);
+				close(f->fd);
+				f->fd = -1;
+				open_files--;
+			}
+		}
+	}
+
+	// only after an io_uring_enter failure: let the reads in flight finish
+	// before their files are closed and the caller gets its memory back,
+	// then report what is still open
+	if (ring_drain(&ring, busy - ring.pending)) err = EBUSY;
+	for (i = 0; i < nbufs; i++)
+		if (files[i].fd >= 0) {
+			done(arg, files[i].index, -1, err);
+			close(files[i].fd);
+		}
+	for (; nextpath < npaths; nextpath++) done(arg, nextpath, -1, err);
+	ring_exit(&ring);
+	return err;
+}
+
+#ifdef STRSTR_URING_MAIN
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static long long *results;
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void record(void *arg, size_t file, long long offset, int err)
+{
+	(void)arg;
+	results[file] = err ? -2 : offset;
+}
+
+/* The blocking way: read(2) each file a buffer at a time, then strstr. */
+static long long blocking(const char *path, const char *needle, char *data,
+                          size_t bufsize)
+{
+	size_t m = strlen(needle), keep = 0;
+	long long off = 0, at;
+	ssize_t n;
+	int fd;
+
+	if ((fd = open(path, O_RDONLY)) < 0) return -2;
+	if (!m) {
+		// found at 0 in any file, as strstr_uring_search reports it
+		close(fd);
+		return 0;
+	}
+	while ((n = read(fd, data + keep, bufsize - keep)) > 0) {
+		n += keep;
+		if ((at = search(data, n, needle)) >= 0) {
+			close(fd);
+			return off + at;
+		}
+		keep = (size_t)n < m - 1 ? (size_t)n : m - 1;
+		memmove(data, data + n - keep, keep);
+		off += n - keep;
+	}
+	close(fd);
+	return n < 0 ? -2 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t bufsize = 128 << 10, i, nfiles;
+	unsigned nbufs = 32;
+	long long bytes = 0, *want;
+	double t, tb = 0, tu = 0;
+	char *data, *needle;
+	void *mem;
+	struct stat st;
+	int opt, pass, err, bad = 0;
+
+	while ((opt = getopt(argc, argv, "b:n:")) != -1) {
+		switch (opt) {
+		case 'b': bufsize = strtoul(optarg, NULL, 0); break;
+		case 'n': nbufs = strtoul(optarg, NULL, 0); break;
+		default: goto usage;
+		}
+	}
+	if (argc - optind < 2) {
+usage:
+		fprintf(stderr, "usage: %s [-b bufsize] [-n nbufs] needle file...\n",
+		        argv[0]);
+		return 2;
+	}
+	needle = argv[optind++];
+	nfiles = argc - optind;
+	for (i = 0; i < nfiles; i++)
+		if (stat(argv[optind + i], &st) == 0) bytes += st.st_size;
+	if (!(results = malloc(nfiles * sizeof *results))
+			|| !(want = malloc(nfiles * sizeof *want))
+			|| !(data = malloc(bufsize + 1))
+			|| !(mem = malloc(strstr_uring_memsize(bufsize, nbufs)))) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	// two passes each, alternating; the first warms the page cache
+	for (pass = 0; pass < 2; pass++) {
+		t = now();
+		for (i = 0; i < nfiles; i++)
+			want[i] = blocking(argv[optind + i], needle, data, bufsize);
+		tb = now() - t;
+		t = now();
+		err = strstr_uring_search((const char *const *)argv + optind, nfiles,
+		                          needle, mem, bufsize, nbufs, record, NULL);
+		tu = now() - t;
+		if (err) {
+			fprintf(stderr, "strstr_uring_search: %s\n", strerror(err));
+			return 1;
+		}
+	}
+	for (i = 0; i < nfiles; i++)
+		if (results[i] != want[i]) {
+			fprintf(stderr, "%s: io_uring found %lld, read found %lld\n",
+			        argv[optind + i], results[i], want[i]);
+			bad = 1;
+		}
+	printf("%zu files, %lld bytes\n", nfiles, bytes);
+	printf("read + strstr:  %8.1f MB/s\n", bytes / tb / 1e6);
+	printf("io_uring:       %8.1f MB/s\n", bytes / tu / 1e6);
+	return bad;
+}
+#endif